@@ -0,0 +1,33 @@
+#include "Benchmarks.h"
+#include <cstring>
+
+// Runs every benchmark, or only the ones named on the command line.
+int main (int argc, char** argv)
+{
+    struct Entry
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const Entry benchmarks[] = {
+        { "workers", Benchmarks::runWorkerScaling },
+        { "denormals", Benchmarks::runDenormals },
+        { "reverb", Benchmarks::runReverb },
+    };
+
+    for (const auto& benchmark : benchmarks)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected = selected || std::strcmp (argv[i], benchmark.name) == 0;
+
+        if (! selected)
+            continue;
+
+        std::printf ("%s\n", benchmark.name);
+        benchmark.run();
+    }
+
+    return 0;
+}
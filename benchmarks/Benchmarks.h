@@ -0,0 +1,37 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cstdio>
+
+//==============================================================================
+// Shared bits of the benchmark app. Each benchmark renders a fixed amount of
+// audio and reports its cost as a realtime load: seconds of CPU per second of
+// audio, so 1.0 is a full core.
+namespace Benchmarks
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    // Calls renderBlock() for seconds of audio in blockSize steps and returns
+    // the realtime load.
+    template <typename RenderBlock>
+    double measureLoad (double seconds, RenderBlock&& renderBlock)
+    {
+        const int numBlocks = juce::jmax (1, (int) (seconds * sampleRate / blockSize));
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int b = 0; b < numBlocks; ++b)
+            renderBlock();
+
+        const double cpuSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        return cpuSeconds * sampleRate / ((double) numBlocks * blockSize);
+    }
+
+    inline void printLoad (const char* label, double load, double reference)
+    {
+        std::printf ("  %-32s %7.3f%% of a core  (%.2fx)\n", label, 100.0 * load, reference / load);
+    }
+
+    void runWorkerScaling();
+    void runDenormals();
+    void runReverb();
+}
@@ -0,0 +1,99 @@
+#include "Benchmarks.h"
+#include "plugin/PluginProcessor.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Mean and 99th percentile block time; the percentile rather than the
+    // worst block, so one preemption of the benchmark thread is not reported
+    // as a spike.
+    struct PhaseTiming
+    {
+        double meanSeconds = 0.0;
+        double p99Seconds = 0.0;
+    };
+
+    // One held note, its release decaying towards zero and then a long stretch
+    // of silence, through a resonant voice, the delay and the reverb. The
+    // voice is rendered even while idle, so its ladders and the FX feedback
+    // paths decay all the way down through the denormal range.
+    void runDecayPass (bool flushToZero)
+    {
+        using namespace Benchmarks;
+
+        juce::FloatVectorOperations::disableDenormalisedNumberSupport (flushToZero);
+
+        AcidVoice voice;
+        voice.prepare (sampleRate, blockSize);
+        voice.setParams (0.3f, 400.0f, 0.95f, 0.4f, 4.0f, 6.0f, 0.0f, 0.0f, 0.2f, 0.0f, 0.0f,
+                         0.0f, 0.0f, 1.0f, 0);
+
+        StereoDelay delay;
+        delay.prepare (sampleRate, 2.0, blockSize);
+        delay.setDelayTimeMs (375.0f, false);
+
+        FdnReverb reverb;
+        reverb.prepare (sampleRate, blockSize);
+        reverb.setParameters ({ 0.9f, 0.3f, 0.47f, 1.0f });
+
+        std::vector<float> left ((size_t) blockSize), right ((size_t) blockSize);
+
+        auto runPhase = [&] (double seconds)
+        {
+            const int numBlocks = (int) (seconds * sampleRate / blockSize);
+            std::vector<double> blockSeconds ((size_t) numBlocks);
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                std::fill (left.begin(), left.end(), 0.0f);
+                std::fill (right.begin(), right.end(), 0.0f);
+                voice.renderBlock (left.data(), right.data(), blockSize);
+                delay.process (left.data(), right.data(), blockSize, nullptr, 0.5f);
+                reverb.process (left.data(), right.data(), blockSize, nullptr, 1.0f);
+
+                blockSeconds[(size_t) b] = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+            }
+
+            PhaseTiming timing;
+            for (auto t : blockSeconds)
+                timing.meanSeconds += t / numBlocks;
+
+            const auto p99 = blockSeconds.begin() + (numBlocks * 99) / 100;
+            std::nth_element (blockSeconds.begin(), p99, blockSeconds.end());
+            timing.p99Seconds = *p99;
+            return timing;
+        };
+
+        voice.noteOn (33, 1.0f);
+        const auto note = runPhase (1.0);
+        voice.noteOff (33);
+        const auto decay = runPhase (10.0);
+        const auto silence = runPhase (30.0);
+
+        juce::FloatVectorOperations::disableDenormalisedNumberSupport (false);
+
+        const double blockPeriod = blockSize / sampleRate;
+        auto print = [&] (const char* phase, const PhaseTiming& timing)
+        {
+            std::printf ("  FTZ %-3s %-8s mean %7.3f%%  p99 %7.3f%% of a block period  (mean %.2fx the note's)\n",
+                         flushToZero ? "on" : "off", phase, 100.0 * timing.meanSeconds / blockPeriod,
+                         100.0 * timing.p99Seconds / blockPeriod, timing.meanSeconds / note.meanSeconds);
+        };
+
+        print ("note", note);
+        print ("decay", decay);
+        print ("silence", silence);
+    }
+}
+
+// Denormal spikes show up as decay and silence blocks costing several times
+// what the note itself did. With the block-level flushing in the voice and
+// the FX they should not, with flush-to-zero off as well as on.
+void Benchmarks::runDenormals()
+{
+    runDecayPass (true);
+    runDecayPass (false);
+}
@@ -0,0 +1,94 @@
+#include "Benchmarks.h"
+#include "plugin/FdnReverb.h"
+#include <vector>
+
+namespace
+{
+    // Stereo noise, so the reverbs never see silence and skip nothing.
+    void fillNoise (juce::Random& random, std::vector<float>& left, std::vector<float>& right)
+    {
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            left[i] = 0.2f * (random.nextFloat() - 0.5f);
+            right[i] = 0.2f * (random.nextFloat() - 0.5f);
+        }
+    }
+}
+
+// The FX reverb's tiers against juce::Reverb, at the settings the processor
+// uses for the default Reverb amount, and the worst block while the tiers
+// are switched back and forth.
+void Benchmarks::runReverb()
+{
+    constexpr double seconds = 20.0;
+    constexpr float mix = 0.25f;
+
+    const float roomSize = 0.2f + 0.7f * mix;
+    const float damping = 0.45f + 0.35f * mix;
+    const float wetLevel = 0.12f + 0.35f * mix;
+    const float dryLevel = 1.0f - 0.2f * mix;
+
+    std::vector<float> left ((size_t) blockSize), right ((size_t) blockSize);
+    juce::Random random (1);
+
+    juce::Reverb reference;
+    reference.setSampleRate (sampleRate);
+
+    juce::Reverb::Parameters referenceParams;
+    referenceParams.roomSize = roomSize;
+    referenceParams.damping = damping;
+    referenceParams.wetLevel = wetLevel;
+    referenceParams.dryLevel = dryLevel;
+    reference.setParameters (referenceParams);
+
+    const double referenceLoad = measureLoad (seconds, [&]
+    {
+        fillNoise (random, left, right);
+        reference.processStereo (left.data(), right.data(), blockSize);
+    });
+
+    printLoad ("juce::Reverb", referenceLoad, referenceLoad);
+
+    const char* tierNames[] = { "FdnReverb economy", "FdnReverb standard", "FdnReverb high" };
+
+    for (int tier = 0; tier < 3; ++tier)
+    {
+        FdnReverb reverb;
+        reverb.setQuality ((FdnReverb::Quality) tier);
+        reverb.prepare (sampleRate, blockSize);
+        reverb.setParameters ({ roomSize, damping, wetLevel, dryLevel });
+
+        const double load = measureLoad (seconds, [&]
+        {
+            fillNoise (random, left, right);
+            reverb.process (left.data(), right.data(), blockSize, nullptr, 1.0f);
+        });
+
+        printLoad (tierNames[tier], load, referenceLoad);
+    }
+
+    // A tier change must not cost a block more than the reverb itself does.
+    FdnReverb reverb;
+    reverb.prepare (sampleRate, blockSize);
+    reverb.setParameters ({ roomSize, damping, wetLevel, dryLevel });
+
+    const int numBlocks = (int) (seconds * sampleRate / blockSize);
+    const int switchInterval = (int) (0.25 * sampleRate / blockSize);
+    double worstSeconds = 0.0;
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        fillNoise (random, left, right);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        if (b % switchInterval == 0)
+            reverb.setQuality ((FdnReverb::Quality) ((b / switchInterval) % 3));
+
+        reverb.process (left.data(), right.data(), blockSize, nullptr, 1.0f);
+
+        worstSeconds = juce::jmax (worstSeconds, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+    }
+
+    std::printf ("  %-32s %7.3f%% of a block period\n", "worst block, switching tiers", 100.0 * worstSeconds * sampleRate / blockSize);
+}
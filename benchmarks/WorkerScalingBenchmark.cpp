@@ -0,0 +1,47 @@
+#include "Benchmarks.h"
+#include "plugin/PluginProcessor.h"
+#include <vector>
+
+// A full poly voice rendered on the audio thread alone and then with 1..N
+// render workers, reporting each against the single-threaded load.
+void Benchmarks::runWorkerScaling()
+{
+    constexpr double seconds = 10.0;
+
+    AcidVoice voice;
+    voice.prepare (sampleRate, blockSize);
+    voice.setParams (0.5f, 900.0f, 0.7f, 0.6f, 1.5f, 1.0f, 0.5f, 0.0f, 0.4f, 0.3f, 0.3f,
+                     0.0f, 0.0f, 1.0f, 0);
+    voice.setVoiceMode (true, AcidVoice::maxPolyVoices);
+
+    std::vector<float> left ((size_t) blockSize), right ((size_t) blockSize);
+    RenderWorkerPool pool;
+
+    const int maxWorkers = juce::jmin (RenderWorkerPool::maxWorkers, juce::SystemStats::getNumCpus() - 1);
+    double singleThreaded = 0.0;
+
+    for (int numWorkers = 0; numWorkers <= maxWorkers; ++numWorkers)
+    {
+        pool.start (numWorkers, sampleRate, blockSize);
+        voice.setRenderWorkers (numWorkers > 0 ? &pool : nullptr);
+
+        // every voice held, so every group is a job in every block
+        for (int v = 0; v < AcidVoice::maxPolyVoices; ++v)
+            voice.noteOn (36 + v, 0.8f);
+
+        const double load = measureLoad (seconds, [&] { voice.renderBlock (left.data(), right.data(), blockSize); });
+
+        if (numWorkers == 0)
+            singleThreaded = load;
+
+        char label[32];
+        std::snprintf (label, sizeof (label), "%d thread(s)", numWorkers + 1);
+        printLoad (label, load, singleThreaded);
+
+        for (int v = 0; v < AcidVoice::maxPolyVoices; ++v)
+            voice.noteOff (36 + v);
+    }
+
+    voice.setRenderWorkers (nullptr);
+    pool.stop();
+}
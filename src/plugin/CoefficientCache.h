@@ -0,0 +1,110 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+
+//==============================================================================
+// exp (-1 / (sr * seconds)) style decay coefficient that is only recomputed
+// when the time it is keyed on actually changes. Call reset() whenever the
+// sample rate changes.
+class CachedDecayCoef
+{
+public:
+    void reset()
+    {
+        lastSeconds = -1.0f;
+        value = 0.0f;
+    }
+
+    float get (float seconds, float sampleRate)
+    {
+        if (seconds != lastSeconds)
+        {
+            lastSeconds = seconds;
+            value = (seconds <= 0.0f) ? 0.0f : std::exp (-1.0f / (sampleRate * seconds));
+        }
+
+        return value;
+    }
+
+private:
+    float lastSeconds = -1.0f;
+    float value = 0.0f;
+};
+
+//==============================================================================
+// std::pow (x, exponent) for a fixed exponent, recomputed only when x changes.
+class CachedPow
+{
+public:
+    explicit CachedPow (float exponentToUse) : exponent (exponentToUse) {}
+
+    float get (float x)
+    {
+        if (x != lastX)
+        {
+            lastX = x;
+            value = std::pow (x, exponent);
+        }
+
+        return value;
+    }
+
+private:
+    float exponent = 1.0f;
+    float lastX = 0.0f;
+    float value = 0.0f;
+};
+
+//==============================================================================
+// Interpolated lookup tables for the coefficients that are modulated
+// continuously (cutoff, pitch, resonance), shared by every voice.
+// Worst-case absolute error against the exact expressions over each domain:
+//   onePoleG   (w = fc / sr, 0..1)       1 - exp (-2 pi w)     < 2e-6
+//   pitchRatio (semitones, -36..36)      2^(semitones / 12)    < 5e-6
+//   resCurve   (res, 0..1)               res^1.35              < 2e-5 (worst just above 0)
+//   panLeft    (pan, -1..1)              see PanLaw            < 1e-6
+struct CoefficientTables
+{
+    // Left-channel gain against pan; the right gain is the mirror image. All
+    // three are constant-power-style laws that only differ in the centre level.
+    enum PanLaw
+    {
+        panLawMinus3dB,     // cos: equal power, centre -3 dB
+        panLawMinus4_5dB,   // geometric mean of the other two, centre -4.5 dB
+        panLawMinus6dB,     // linear: equal amplitude, centre -6 dB
+        numPanLaws
+    };
+
+    juce::dsp::LookupTableTransform<float> onePoleG;
+    juce::dsp::LookupTableTransform<float> pitchRatio;
+    juce::dsp::LookupTableTransform<float> resCurve;
+    std::array<juce::dsp::LookupTableTransform<float>, numPanLaws> panLeft;
+
+    static const CoefficientTables& get()
+    {
+        static const CoefficientTables tables;
+        return tables;
+    }
+
+private:
+    CoefficientTables()
+    {
+        onePoleG.initialise ([] (float w) { return 1.0f - std::exp (-2.0f * juce::MathConstants<float>::pi * w); },
+                             0.0f, 1.0f, 2048);
+        // odd size keeps 0 semitones on a grid point, so an unmodulated pitch stays exactly 1
+        pitchRatio.initialise ([] (float semis) { return std::pow (2.0f, semis / 12.0f); },
+                               -36.0f, 36.0f, 4097);
+        resCurve.initialise ([] (float r) { return std::pow (r, 1.35f); },
+                             0.0f, 1.0f, 1024);
+
+        // odd size keeps centre pan on a grid point, so the centre gain is exact
+        auto equalPower = [] (float pan) { return std::cos ((pan + 1.0f) * 0.25f * juce::MathConstants<float>::pi); };
+        auto linear = [] (float pan) { return 0.5f * (1.0f - pan); };
+
+        panLeft[panLawMinus3dB].initialise (equalPower, -1.0f, 1.0f, 1025);
+        panLeft[panLawMinus4_5dB].initialise ([=] (float pan) { return std::sqrt (juce::jmax (0.0f, equalPower (pan)) * linear (pan)); },
+                                              -1.0f, 1.0f, 1025);
+        panLeft[panLawMinus6dB].initialise (linear, -1.0f, 1.0f, 1025);
+    }
+};
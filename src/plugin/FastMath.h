@@ -0,0 +1,225 @@
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Build-time precision switch (CMake option ACID_LADDER_FAST_MATH).
+// 1: DspMath:: uses the FastMath:: approximations below.
+// 0: DspMath:: forwards to the exact std:: functions (for A/B and regression renders).
+#ifndef ACID_LADDER_FAST_MATH
+ #define ACID_LADDER_FAST_MATH 1
+#endif
+
+#if JUCE_USE_SIMD && (defined (__SSE2__) || defined (_M_X64) || defined (__amd64__))
+ #define ACID_FAST_MATH_SSE 1
+#elif JUCE_USE_SIMD && (defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (__aarch64__))
+ #define ACID_FAST_MATH_NEON 1
+#endif
+
+//==============================================================================
+// Bounded-error approximations for the DSP hot path. Every function has a scalar
+// overload and a juce::dsp::SIMDRegister<float> overload built from the same
+// polynomial, so a lane of the SIMD version matches the scalar one.
+//
+// Maximum error, measured against double-precision std:: over the stated domain:
+//   exp2 (x)   relative < 3e-7     x in [-126, 126] (input clamped outside)
+//   exp (x)    relative < 5e-6     x in [-87, 87];  < 3e-7 for x in [-1, 1]
+//   sin (x)    absolute < 3e-7     x in [-1000, 1000]
+//   cos (x)    absolute < 3e-7     x in [-1000, 1000]
+//   tanh (x)   absolute < 1e-4     all x (Pade 7/6 on [-4.97, 4.97], saturates outside)
+namespace FastMath
+{
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    namespace detail
+    {
+        // adding and removing 1.5 * 2^23 rounds to the nearest integer for |x| < 2^22
+        constexpr float roundMagic = 12582912.0f;
+
+        constexpr float invPi = 0.318309886183790671538f;
+        // Cody-Waite split of pi: piHi has few enough mantissa bits that n * piHi is exact
+        constexpr float piHi = 3.140625f;
+        constexpr float piLo = 9.67653589793e-4f;
+
+        inline float roundNearest (float x) noexcept          { return (x + roundMagic) - roundMagic; }
+        inline float absOf (float x) noexcept                 { return std::abs (x); }
+        inline float clampTo (float x, float lo, float hi) noexcept { return juce::jlimit (lo, hi, x); }
+        inline float divide (float a, float b) noexcept       { return a / b; }
+
+        // p * 2^n for an integer-valued n in [-126, 127]
+        inline float scaleByPow2 (float p, float n) noexcept
+        {
+            const auto bits = (int32_t) (((int32_t) n + 127) << 23);
+            float scale;
+            std::memcpy (&scale, &bits, sizeof (scale));
+            return p * scale;
+        }
+
+       #if JUCE_USE_SIMD
+        inline SIMDFloat roundNearest (SIMDFloat x) noexcept  { return (x + roundMagic) - roundMagic; }
+        inline SIMDFloat absOf (SIMDFloat x) noexcept         { return SIMDFloat::max (x, SIMDFloat::expand (0.0f) - x); }
+
+        inline SIMDFloat clampTo (SIMDFloat x, float lo, float hi) noexcept
+        {
+            return SIMDFloat::min (SIMDFloat::max (x, SIMDFloat::expand (lo)), SIMDFloat::expand (hi));
+        }
+
+        inline SIMDFloat divide (SIMDFloat a, SIMDFloat b) noexcept
+        {
+            SIMDFloat r;
+           #if ACID_FAST_MATH_SSE
+            r.value = _mm_div_ps (a.value, b.value);
+           #elif ACID_FAST_MATH_NEON && defined (__aarch64__)
+            r.value = vdivq_f32 (a.value, b.value);
+           #else
+            for (size_t i = 0; i < SIMDFloat::size(); ++i)
+                r.set (i, a.get (i) / b.get (i));
+           #endif
+            return r;
+        }
+
+        inline SIMDFloat scaleByPow2 (SIMDFloat p, SIMDFloat n) noexcept
+        {
+            SIMDFloat scale;
+           #if ACID_FAST_MATH_SSE
+            scale.value = _mm_castsi128_ps (_mm_slli_epi32 (_mm_add_epi32 (_mm_cvtps_epi32 (n.value),
+                                                                           _mm_set1_epi32 (127)), 23));
+           #elif ACID_FAST_MATH_NEON
+            scale.value = vreinterpretq_f32_s32 (vshlq_n_s32 (vaddq_s32 (vcvtq_s32_f32 (n.value),
+                                                                         vdupq_n_s32 (127)), 23));
+           #else
+            for (size_t i = 0; i < SIMDFloat::size(); ++i)
+                scale.set (i, scaleByPow2 (1.0f, n.get (i)));
+           #endif
+            return p * scale;
+        }
+       #endif
+
+        template <typename V>
+        inline V exp2 (V x) noexcept
+        {
+            x = clampTo (x, -126.0f, 126.0f);
+            const V n = roundNearest (x);
+            const V f = x - n; // [-0.5, 0.5]
+
+            // degree-6 Taylor series of 2^f; the remainder is below 1.2e-7 on |f| <= 0.5
+            V p = f * 1.5403530e-4f + 1.3333558e-3f;
+            p = p * f + 9.6181291e-3f;
+            p = p * f + 5.5504109e-2f;
+            p = p * f + 2.4022651e-1f;
+            p = p * f + 6.9314718e-1f;
+            p = p * f + 1.0f;
+            return scaleByPow2 (p, n);
+        }
+
+        // (-1)^n * sin (r) for r in [-pi/2, pi/2]; degree-11 Taylor remainder < 6e-8
+        template <typename V>
+        inline V signedSin (V n, V r) noexcept
+        {
+            const V parity = absOf (n - roundNearest (n * 0.5f) * 2.0f); // 0 or 1
+            const V sign = parity * -2.0f + 1.0f;
+
+            const V r2 = r * r;
+            V p = r2 * -2.5052108e-8f + 2.7557319e-6f;
+            p = p * r2 - 1.9841270e-4f;
+            p = p * r2 + 8.3333333e-3f;
+            p = p * r2 - 1.6666667e-1f;
+            p = p * r2 + 1.0f;
+            return sign * (p * r);
+        }
+
+        template <typename V>
+        inline V sin (V x) noexcept
+        {
+            const V n = roundNearest (x * invPi);
+            const V r = (x - n * piHi) - n * piLo;
+            return signedSin (n, r);
+        }
+
+        template <typename V>
+        inline V cos (V x) noexcept
+        {
+            // cos (x) = sin (x + pi/2), reduced around the odd multiples of pi/2
+            const V m = roundNearest (x * invPi - 0.5f);
+            const V h = m + 0.5f;
+            const V r = (x - h * piHi) - h * piLo;
+            return signedSin (m + 1.0f, r);
+        }
+
+        template <typename V>
+        inline V tanh (V x) noexcept
+        {
+            const V xc = clampTo (x, -4.97f, 4.97f);
+            const V x2 = xc * xc;
+            const V num = xc * (((x2 + 378.0f) * x2 + 17325.0f) * x2 + 135135.0f);
+            const V den = ((x2 * 28.0f + 3150.0f) * x2 + 62370.0f) * x2 + 135135.0f;
+            return clampTo (divide (num, den), -1.0f, 1.0f);
+        }
+    }
+
+    inline float exp2 (float x) noexcept { return detail::exp2 (x); }
+    inline float exp (float x) noexcept  { return detail::exp2 (x * 1.44269504089f); }
+    inline float sin (float x) noexcept  { return detail::sin (x); }
+    inline float cos (float x) noexcept  { return detail::cos (x); }
+    inline float tanh (float x) noexcept { return detail::tanh (x); }
+
+    // Lane helpers, so code written once for float and SIMDFloat can use them.
+    inline float abs (float x) noexcept                          { return detail::absOf (x); }
+    inline float divide (float a, float b) noexcept              { return detail::divide (a, b); }
+    inline float clamp (float x, float lo, float hi) noexcept    { return detail::clampTo (x, lo, hi); }
+
+   #if JUCE_USE_SIMD
+    inline SIMDFloat abs (SIMDFloat x) noexcept                 { return detail::absOf (x); }
+    inline SIMDFloat divide (SIMDFloat a, SIMDFloat b) noexcept { return detail::divide (a, b); }
+    inline SIMDFloat clamp (SIMDFloat x, float lo, float hi) noexcept { return detail::clampTo (x, lo, hi); }
+
+    inline SIMDFloat exp2 (SIMDFloat x) noexcept { return detail::exp2 (x); }
+    inline SIMDFloat exp (SIMDFloat x) noexcept  { return detail::exp2 (x * 1.44269504089f); }
+    inline SIMDFloat sin (SIMDFloat x) noexcept  { return detail::sin (x); }
+    inline SIMDFloat cos (SIMDFloat x) noexcept  { return detail::cos (x); }
+    inline SIMDFloat tanh (SIMDFloat x) noexcept { return detail::tanh (x); }
+   #endif
+}
+
+//==============================================================================
+// What the DSP code calls: FastMath or std:: depending on ACID_LADDER_FAST_MATH.
+namespace DspMath
+{
+   #if ACID_LADDER_FAST_MATH
+    inline float exp2 (float x) noexcept { return FastMath::exp2 (x); }
+    inline float exp (float x) noexcept  { return FastMath::exp (x); }
+    inline float sin (float x) noexcept  { return FastMath::sin (x); }
+    inline float cos (float x) noexcept  { return FastMath::cos (x); }
+    inline float tanh (float x) noexcept { return FastMath::tanh (x); }
+   #else
+    inline float exp2 (float x) noexcept { return std::exp2 (x); }
+    inline float exp (float x) noexcept  { return std::exp (x); }
+    inline float sin (float x) noexcept  { return std::sin (x); }
+    inline float cos (float x) noexcept  { return std::cos (x); }
+    inline float tanh (float x) noexcept { return std::tanh (x); }
+   #endif
+
+   #if JUCE_USE_SIMD
+    using SIMDFloat = FastMath::SIMDFloat;
+
+   #if ACID_LADDER_FAST_MATH
+    inline SIMDFloat sin (SIMDFloat x) noexcept  { return FastMath::sin (x); }
+    inline SIMDFloat cos (SIMDFloat x) noexcept  { return FastMath::cos (x); }
+    inline SIMDFloat tanh (SIMDFloat x) noexcept { return FastMath::tanh (x); }
+   #else
+    template <typename Fn>
+    inline SIMDFloat applyPerLane (SIMDFloat x, Fn&& fn) noexcept
+    {
+        for (size_t i = 0; i < SIMDFloat::size(); ++i)
+            x.set (i, fn (x.get (i)));
+
+        return x;
+    }
+
+    inline SIMDFloat sin (SIMDFloat x) noexcept  { return applyPerLane (x, [] (float v) { return std::sin (v); }); }
+    inline SIMDFloat cos (SIMDFloat x) noexcept  { return applyPerLane (x, [] (float v) { return std::cos (v); }); }
+    inline SIMDFloat tanh (SIMDFloat x) noexcept { return applyPerLane (x, [] (float v) { return std::tanh (v); }); }
+   #endif
+   #endif
+}
@@ -0,0 +1,390 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterRamp.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+//==============================================================================
+// The FX reverb: a feedback delay network. Every line feeds every other one
+// through a Householder matrix (x - 2/N * sum (x)), which costs O(N) and mixes
+// as densely as a full matrix, so 8 lines build echo density about as fast as
+// juce::Reverb's 16 combs and 8 allpasses.
+//
+// The lines are stored interleaved, one row of maxLines floats per sample, so
+// each sample's write and all of the per-line work (damping, matrix, decay,
+// input and output taps) run a SIMD register of lines at a time. Only the
+// reads, which sit at a different delay per line, are scalar.
+//
+// Quality tiers trade CPU for smoothness:
+//   economy   8 lines, no input diffusion
+//   standard  8 lines, two allpass diffusers per input channel
+//   high     16 lines, four allpass diffusers per input channel
+//
+// Nothing on the audio thread clears the lines in one go: reset() only
+// restarts a count of the rows written since, and a line reads as silent
+// until the count reaches its length, by which time its rows hold new
+// samples. A tier change fades the wet output out, swaps the layout at the
+// start of the next block that finds it silent, and fades back in.
+class FdnReverb
+{
+public:
+    enum class Quality
+    {
+        economy,
+        standard,
+        high
+    };
+
+    // Same meaning and ranges as juce::Reverb::Parameters (0..1 each).
+    struct Parameters
+    {
+        float roomSize = 0.5f;
+        float damping = 0.5f;
+        float wetLevel = 0.33f;
+        float dryLevel = 0.4f;
+
+        bool operator== (const Parameters& other) const noexcept
+        {
+            return roomSize == other.roomSize && damping == other.damping
+                && wetLevel == other.wetLevel && dryLevel == other.dryLevel;
+        }
+
+        bool operator!= (const Parameters& other) const noexcept { return ! (*this == other); }
+    };
+
+    static constexpr int maxLines = 16;
+
+    // Time for the tail to fall by 60 dB. Matches the decay juce::Reverb gives
+    // the same room size (comb feedback 0.7 + 0.28 * roomSize over its mean
+    // comb length), so presets keep their length.
+    static double getDecaySeconds (float roomSize) noexcept
+    {
+        const double feedback = 0.7 + 0.28 * juce::jlimit (0.0, 1.0, (double) roomSize);
+        return 3.0 * meanFreeverbCombSeconds / -std::log10 (feedback);
+    }
+
+    // The longest line, for tail estimates.
+    static double getLongestLineSeconds() noexcept { return lineLengths44k[maxLines - 1] / 44100.0; }
+
+    void prepare (double sampleRate, int maximumBlockSize)
+    {
+        sr = sampleRate;
+
+        const double scale = sampleRate / 44100.0;
+        int longest = 1;
+
+        for (size_t k = 0; k < (size_t) maxLines; ++k)
+        {
+            delays[k] = juce::jmax (1, juce::roundToInt (lineLengths44k[k] * scale));
+            longest = juce::jmax (longest, delays[k]);
+        }
+
+        const int rows = juce::nextPowerOfTwo (longest + 1);
+        rowMask = rows - 1;
+
+        // over-allocated so the rows can start on a register boundary
+        lineStorage.assign ((size_t) rows * (size_t) maxLines + (size_t) maxLines, 0.0f);
+        const auto misalignment = (reinterpret_cast<uintptr_t> (lineStorage.data()) / sizeof (float)) % (size_t) maxLines;
+        lines = lineStorage.data() + (misalignment == 0 ? 0 : (size_t) maxLines - misalignment);
+
+        for (int c = 0; c < 2; ++c)
+            for (size_t s = 0; s < (size_t) maxDiffusers; ++s)
+                diffusers[(size_t) c][s].prepare (juce::roundToInt ((diffuserLengths44k[s] + (float) (c * stereoSpread44k)) * scale));
+
+        dryRamp.prepare (sampleRate, 0.02, maximumBlockSize);
+        wetRamp.prepare (sampleRate, 0.02, maximumBlockSize);
+        tierFade.prepare (sampleRate, 0.02, maximumBlockSize);
+        tierFade.setCurrentAndTargetValue (1.0f);
+
+        applyQuality (pendingQuality);
+    }
+
+    // Silences the tail. Cheap enough for the audio thread: the lines are
+    // left as they are and masked until they have been rewritten.
+    void reset()
+    {
+        lowpass.fill (0.0f);
+        rowsWritten = 0;
+
+        for (auto& channel : diffusers)
+            for (auto& diffuser : channel)
+                diffuser.reset();
+
+        dryRamp.setCurrentAndTargetValue (dryRamp.getTargetValue());
+        wetRamp.setCurrentAndTargetValue (wetRamp.getTargetValue());
+    }
+
+    // The new tier starts from silence (the lines are laid out differently),
+    // after the old tail has faded out; see process().
+    void setQuality (Quality newQuality)
+    {
+        pendingQuality = newQuality;
+        tierFade.setTargetValue ((newQuality == quality) ? 1.0f : 0.0f);
+    }
+
+    const Parameters& getParameters() const noexcept { return applied; }
+
+    // Cheap to call every block: nothing is recomputed unless a value changed.
+    void setParameters (const Parameters& newParams)
+    {
+        if (appliedValid && newParams == applied)
+            return;
+
+        const bool snap = ! appliedValid;
+        applied = newParams;
+        appliedValid = true;
+
+        // juce::Reverb scales dry by 2 and wet by 3; kept so the mix level is
+        // unchanged (a dry level of 0.5 passes the input at unity)
+        const float dry = 2.0f * newParams.dryLevel;
+        const float wet = 3.0f * newParams.wetLevel;
+
+        if (snap)
+        {
+            dryRamp.setCurrentAndTargetValue (dry);
+            wetRamp.setCurrentAndTargetValue (wet);
+        }
+        else
+        {
+            dryRamp.setTargetValue (dry);
+            wetRamp.setTargetValue (wet);
+        }
+
+        damping = 0.4f * juce::jlimit (0.0f, 1.0f, newParams.damping);
+        updateDecayGains();
+    }
+
+    // right may be nullptr for a mono output; the reverb then takes left only
+    // and returns the average of its two outputs. sendValues (nullptr unless
+    // it fades in this block) or send scales the input into the network only,
+    // so fading it out lets the tail ring on.
+    void process (float* left, float* right, int numSamples, const float* sendValues, float send)
+    {
+        // a pending tier change waits until its fade-out is done, or the tail is already gone
+        if (pendingQuality != quality && (rowsWritten == 0 || (! tierFade.isSmoothing() && tierFade.getTargetValue() == 0.0f)))
+        {
+            applyQuality (pendingQuality);
+            tierFade.setTargetValue (1.0f);
+        }
+
+        // each is nullptr unless that level is moving in this block
+        const float* dryValues = dryRamp.process (numSamples);
+        const float* wetValues = wetRamp.process (numSamples);
+        const float* fadeValues = tierFade.process (numSamples);
+        const float dry = dryRamp.getTargetValue();
+        const float wet = wetRamp.getTargetValue() * tierFade.getTargetValue();
+        const float mixScale = householderScale();
+        const Lanes dampLanes = splatLanes (damping);
+        const auto numLanes = (size_t) numLines;
+
+        alignas (32) std::array<float, (size_t) maxLines> taps {};
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float inGain = inputGain * ((sendValues != nullptr) ? sendValues[i] : send);
+            float inL = left[i] * inGain;
+            float inR = (right != nullptr) ? right[i] * inGain : inL;
+
+            for (size_t s = 0; s < (size_t) numDiffusers; ++s)
+            {
+                inL = diffusers[0][s].process (inL);
+                inR = diffusers[1][s].process (inR);
+            }
+
+            // a line reads as silent until it has been rewritten since the last reset
+            for (size_t k = 0; k < numLanes; ++k)
+                taps[k] = (activeDelays[k] <= rowsWritten) ? lines[(size_t) ((writeRow - activeDelays[k]) & rowMask) * maxLines + k]
+                                                           : 0.0f;
+
+            // damping, output taps and the matrix's sum, a register of lines at a time
+            Lanes sum = splatLanes (0.0f), outL = splatLanes (0.0f), outR = splatLanes (0.0f);
+
+            for (size_t k = 0; k < numLanes; k += (size_t) laneWidth)
+            {
+                const Lanes x = loadLanes (&taps[k]);
+                const Lanes lp = x + (loadLanes (&lowpass[k]) - x) * dampLanes;
+                storeLanes (&lowpass[k], lp);
+
+                sum += lp;
+                outL += lp * loadLanes (&outTapL[k]);
+                outR += lp * loadLanes (&outTapR[k]);
+            }
+
+            const Lanes mixed = splatLanes (sumLanes (sum) * mixScale);
+            const Lanes inLLanes = splatLanes (inL);
+            const Lanes inRLanes = splatLanes (inR);
+            float* row = lines + (size_t) writeRow * maxLines;
+
+            for (size_t k = 0; k < numLanes; k += (size_t) laneWidth)
+            {
+                const Lanes fed = (loadLanes (&lowpass[k]) - mixed) * loadLanes (&decayGains[k])
+                                + inLLanes * loadLanes (&inTapL[k]) + inRLanes * loadLanes (&inTapR[k]);
+                storeLanes (row + k, fed);
+            }
+
+            writeRow = (writeRow + 1) & rowMask;
+            rowsWritten = juce::jmin (rowsWritten + 1, rowMask + 1);
+
+            const float dryGain = (dryValues != nullptr) ? dryValues[i] : dry;
+            const float wetGain = (wetValues != nullptr || fadeValues != nullptr)
+                                ? ((wetValues != nullptr) ? wetValues[i] : wetRamp.getTargetValue())
+                                      * ((fadeValues != nullptr) ? fadeValues[i] : tierFade.getTargetValue())
+                                : wet;
+            const float wetL = sumLanes (outL) * wetGain;
+            const float wetR = sumLanes (outR) * wetGain;
+
+            if (right != nullptr)
+            {
+                left[i] = left[i] * dryGain + wetL;
+                right[i] = right[i] * dryGain + wetR;
+            }
+            else
+            {
+                left[i] = left[i] * dryGain + 0.5f * (wetL + wetR);
+            }
+        }
+    }
+
+private:
+   #if JUCE_USE_SIMD
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int laneWidth = (int) Lanes::size();
+    static inline Lanes splatLanes (float x)            { return Lanes::expand (x); }
+    static inline Lanes loadLanes (const float* p)      { return Lanes::fromRawArray (p); }
+    static inline void storeLanes (float* p, Lanes v)   { v.copyToRawArray (p); }
+    static inline float sumLanes (Lanes v)              { return v.sum(); }
+   #else
+    using Lanes = float;
+    static constexpr int laneWidth = 1;
+    static inline float splatLanes (float x)            { return x; }
+    static inline float loadLanes (const float* p)      { return *p; }
+    static inline void storeLanes (float* p, float v)   { *p = v; }
+    static inline float sumLanes (float v)              { return v; }
+   #endif
+
+    static_assert (8 % laneWidth == 0, "the 8-line tiers must fill whole registers");
+
+    // Schroeder allpass, used to smear the input before it enters the network.
+    struct Diffuser
+    {
+        void prepare (int length)
+        {
+            buffer.assign ((size_t) juce::jmax (1, length), 0.0f);
+            pos = 0;
+        }
+
+        void reset() { std::fill (buffer.begin(), buffer.end(), 0.0f); }
+
+        float process (float in) noexcept
+        {
+            const float delayed = buffer[(size_t) pos];
+            const float out = delayed - gain * in;
+            buffer[(size_t) pos] = in + gain * out;
+
+            if (++pos == (int) buffer.size())
+                pos = 0;
+
+            return out;
+        }
+
+        static constexpr float gain = 0.6f;
+        std::vector<float> buffer;
+        int pos = 0;
+    };
+
+    static constexpr int maxDiffusers = 4;
+    static constexpr int stereoSpread44k = 23;   // the right diffusers run a little longer, as in Freeverb
+    static constexpr double meanFreeverbCombSeconds = 1378.0 / 44100.0;
+
+    // mutually prime line lengths in samples at 44.1 kHz, about 23 to 52 ms
+    static constexpr std::array<double, (size_t) maxLines> lineLengths44k {
+        1019.0, 1109.0, 1193.0, 1277.0, 1361.0, 1433.0, 1511.0, 1601.0,
+        1693.0, 1777.0, 1861.0, 1949.0, 2039.0, 2129.0, 2213.0, 2297.0
+    };
+
+    static constexpr std::array<float, (size_t) maxDiffusers> diffuserLengths44k { 142.0f, 107.0f, 379.0f, 277.0f };
+
+    // sets the wet level: noise comes out about as loud as from juce::Reverb
+    // at the same settings, in every tier (each input feeds numLines / 2 lines,
+    // and the output taps are scaled by 1 / sqrt (numLines / 2))
+    static constexpr float inputGain = 0.42f;
+
+    float householderScale() const noexcept { return 2.0f / (float) numLines; }
+
+    void applyQuality (Quality newQuality)
+    {
+        quality = newQuality;
+        numLines = (quality == Quality::high) ? 16 : 8;
+        numDiffusers = (quality == Quality::high) ? 4 : (quality == Quality::standard) ? 2 : 0;
+
+        // with 8 lines, every other entry of the length table keeps the
+        // spread of lengths
+        for (int k = 0; k < maxLines; ++k)
+            activeDelays[(size_t) k] = (k < numLines) ? delays[(size_t) ((numLines == maxLines) ? k : 2 * k + 1)] : 1;
+
+        updateTaps();
+        updateDecayGains();
+        reset();
+    }
+
+    void updateDecayGains()
+    {
+        const double decaySeconds = getDecaySeconds (applied.roomSize);
+        for (size_t k = 0; k < (size_t) maxLines; ++k)
+            decayGains[k] = (k < (size_t) numLines)
+                                ? (float) std::pow (10.0, -3.0 * activeDelays[k] / (decaySeconds * sr))
+                                : 0.0f;
+    }
+
+    // The left input and output use the even lines and the right the odd
+    // ones, with alternating signs so the two outputs are decorrelated.
+    void updateTaps()
+    {
+        const float outGain = 1.0f / std::sqrt ((float) numLines * 0.5f);
+
+        for (int k = 0; k < maxLines; ++k)
+        {
+            const auto i = (size_t) k;
+            const bool active = k < numLines;
+            const float sign = ((k / 2) % 2 == 0) ? 1.0f : -1.0f;
+            const bool isLeft = (k % 2) == 0;
+
+            inTapL[i] = (active && isLeft) ? 1.0f : 0.0f;
+            inTapR[i] = (active && ! isLeft) ? 1.0f : 0.0f;
+            outTapL[i] = (active && isLeft) ? sign * outGain : 0.0f;
+            outTapR[i] = (active && ! isLeft) ? sign * outGain : 0.0f;
+        }
+    }
+
+    double sr = 44100.0;
+    Quality quality = Quality::standard;
+    Quality pendingQuality = Quality::standard;
+    int numLines = 8;
+    int numDiffusers = 2;
+
+    std::array<int, (size_t) maxLines> delays {};         // every line, in samples
+    std::array<int, (size_t) maxLines> activeDelays {};   // the ones the current tier runs
+    std::vector<float> lineStorage;
+    float* lines = nullptr;                              // rows of maxLines samples, aligned
+    int rowMask = 0;
+    int writeRow = 0;
+    int rowsWritten = 0;                                 // since the last reset, up to rowMask + 1
+
+    alignas (32) std::array<float, (size_t) maxLines> lowpass {};
+    alignas (32) std::array<float, (size_t) maxLines> decayGains {};
+    alignas (32) std::array<float, (size_t) maxLines> inTapL {};
+    alignas (32) std::array<float, (size_t) maxLines> inTapR {};
+    alignas (32) std::array<float, (size_t) maxLines> outTapL {};
+    alignas (32) std::array<float, (size_t) maxLines> outTapR {};
+
+    std::array<std::array<Diffuser, (size_t) maxDiffusers>, 2> diffusers;
+
+    Parameters applied;
+    bool appliedValid = false;
+    float damping = 0.0f;
+    ParameterRamp dryRamp, wetRamp;
+    ParameterRamp tierFade;                              // wet output gain across a tier change
+};
@@ -0,0 +1,171 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FxSlot.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//==============================================================================
+// The order the FX stages run in, their bypass slots and what each one costs.
+//
+// Every stage has a fixed slot, built in prepare(); an order is only a
+// permutation of the stage indices, so changing it on the audio thread
+// neither allocates nor locks. The orders are numbered the way the "fxOrder"
+// choice lists them: all 24 permutations in lexicographic order, so index 0
+// is the original Drive > Chorus > Delay > Reverb.
+//
+// process() times each stage with the high-resolution clock and adds the
+// ticks to that stage's counter. Only the audio thread writes the counters
+// and any thread may read them, so they are plain relaxed atomics.
+class FxChain
+{
+public:
+    enum Stage
+    {
+        drive,
+        chorus,
+        delay,
+        reverb,
+        numStages
+    };
+
+    static constexpr int numOrders = 24;   // numStages!
+
+    using Order = std::array<Stage, (size_t) numStages>;
+
+    static const char* getStageName (Stage stage) noexcept
+    {
+        switch (stage)
+        {
+            case drive:  return "Drive";
+            case chorus: return "Chorus";
+            case delay:  return "Delay";
+            case reverb: return "Reverb";
+            case numStages:
+            default:     return "";
+        }
+    }
+
+    // The index-th permutation in lexicographic order: its digits in the
+    // factorial number system pick each stage from the ones not yet placed.
+    static Order getOrder (int index) noexcept
+    {
+        index = juce::jlimit (0, numOrders - 1, index);
+
+        Order remaining { drive, chorus, delay, reverb };
+        int numRemaining = numStages;
+        int radix = numOrders;
+        Order order {};
+
+        for (size_t pos = 0; pos < order.size(); ++pos)
+        {
+            radix /= numRemaining;
+            const int pick = index / radix;
+            index %= radix;
+
+            order[pos] = remaining[(size_t) pick];
+            for (int k = pick; k < numRemaining - 1; ++k)
+                remaining[(size_t) k] = remaining[(size_t) k + 1];
+
+            --numRemaining;
+        }
+
+        return order;
+    }
+
+    // The "fxOrder" choice, e.g. "Drive > Chorus > Delay > Reverb".
+    static juce::StringArray getOrderNames()
+    {
+        juce::StringArray names;
+
+        for (int i = 0; i < numOrders; ++i)
+        {
+            juce::StringArray stages;
+            for (auto stage : getOrder (i))
+                stages.add (getStageName (stage));
+
+            names.add (stages.joinIntoString (" > "));
+        }
+
+        return names;
+    }
+
+    void prepare (double sampleRate, int maximumBlockSize)
+    {
+        for (auto& slot : slots)
+            slot.prepare (sampleRate, maximumBlockSize);
+
+        rate.store (sampleRate, std::memory_order_relaxed);
+        resetUsage();
+    }
+
+    void setOrder (int index) noexcept { order = getOrder (index); }
+    const Order& getOrder() const noexcept { return order; }
+
+    FxSlot& getSlot (Stage stage) noexcept { return slots[(size_t) stage]; }
+    const FxSlot& getSlot (Stage stage) const noexcept { return slots[(size_t) stage]; }
+
+    // Every slot's state, two bits each, so a change in any of them (a stage
+    // waking, starting to tail or going to sleep) shows as a different value.
+    uint32_t getSlotStates() const noexcept
+    {
+        uint32_t states = 0;
+        for (size_t i = 0; i < slots.size(); ++i)
+            states |= (uint32_t) slots[i].getState() << (2 * i);
+
+        return states;
+    }
+
+    // Calls processStage (Stage, FxSlot&) for every stage, in order.
+    template <typename ProcessStage>
+    void process (int numSamples, ProcessStage&& processStage)
+    {
+        for (auto stage : order)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            processStage (stage, slots[(size_t) stage]);
+            add (stageTicks[(size_t) stage], juce::Time::getHighResolutionTicks() - start);
+        }
+
+        add (samplesProcessed, numSamples);
+    }
+
+    struct Usage
+    {
+        double cpuSeconds = 0.0;     // spent in the stage
+        double audioSeconds = 0.0;   // of audio the chain ran over
+    };
+
+    // Totals since prepare(), from any thread. The stage's load over an
+    // interval is the change in cpuSeconds divided by the change in
+    // audioSeconds between two readings.
+    Usage getUsage (Stage stage) const noexcept
+    {
+        Usage usage;
+        usage.cpuSeconds = juce::Time::highResolutionTicksToSeconds (stageTicks[(size_t) stage].load (std::memory_order_relaxed));
+        usage.audioSeconds = (double) samplesProcessed.load (std::memory_order_relaxed) / rate.load (std::memory_order_relaxed);
+        return usage;
+    }
+
+private:
+    void resetUsage() noexcept
+    {
+        for (auto& ticks : stageTicks)
+            ticks.store (0, std::memory_order_relaxed);
+
+        samplesProcessed.store (0, std::memory_order_relaxed);
+    }
+
+    // single writer, so a load and a store are enough
+    static void add (std::atomic<int64_t>& counter, int64_t amount) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    Order order = getOrder (0);
+    std::array<FxSlot, (size_t) numStages> slots;
+
+    std::array<std::atomic<int64_t>, (size_t) numStages> stageTicks {};
+    std::atomic<int64_t> samplesProcessed { 0 };
+    std::atomic<double> rate { 44100.0 };
+};
@@ -0,0 +1,358 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FastMath.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// The FX drive: tanh (x * (1 + 10 * mix)) blended with the dry signal by mix,
+// processed a block at a time.
+//
+// Quality tiers trade CPU for aliasing:
+//   plain          tanh at the base rate, a SIMD register of samples at a time
+//   antialiased    first-order antiderivative antialiasing (ADAA): each output
+//                  is the mean of tanh over the segment between two inputs,
+//                  (F (u[n]) - F (u[n-1])) / (u[n] - u[n-1]) with F = log cosh,
+//                  which rolls off the aliasing without resampling. It puts the
+//                  shaped signal half a sample late, so the dry signal is
+//                  averaged the same way to keep the blend free of combing.
+//   oversampled2x  the plain shaper at 2x through polyphase IIR half-band
+//   oversampled4x  filters (as the voice uses); the whole blend runs at the
+//                  high rate, so dry and shaped see the same filters
+// The resamplers are built in prepare(), so switching never allocates.
+//
+// The resampled tiers delay the signal by a few samples, which the processor
+// reports as latency. The input is kept in a delay line of that length: the
+// send blend mixes with the delayed input, so a send fade does not comb, and
+// processAsleep() passes it on while the stage is switched off, so the
+// reported latency holds whether the drive runs or not.
+class FxDrive
+{
+public:
+    enum class Quality
+    {
+        plain,
+        antialiased,
+        oversampled2x,
+        oversampled4x
+    };
+
+    void prepare (int maximumBlockSize)
+    {
+        maxBlockSize = juce::jmax (1, maximumBlockSize);
+
+        for (size_t i = 0; i < oversamplers.size(); ++i)
+        {
+            oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>> (2, i + 1,
+                                                                                juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                                true, true);
+            oversamplers[i]->initProcessing ((size_t) maxBlockSize);
+        }
+
+        int maxLatency = 0;
+        for (auto& os : oversamplers)
+            maxLatency = juce::jmax (maxLatency, (int) std::round (os->getLatencyInSamples()));
+
+        for (auto& channel : dryInput)
+            channel.assign ((size_t) (maxBlockSize + maxLatency), 0.0f);
+
+        reset();
+    }
+
+    // Clears the resamplers and the ADAA history. The dry delay line keeps
+    // its contents, since processAsleep() goes on reading it.
+    void reset()
+    {
+        for (auto& os : oversamplers)
+            if (os != nullptr)
+                os->reset();
+
+        adaaState = {};
+    }
+
+    // Changing the tier resets the resamplers, the ADAA history and the dry
+    // delay line (the latency changes with it).
+    void setQuality (Quality newQuality)
+    {
+        if (newQuality == quality)
+            return;
+
+        quality = newQuality;
+        reset();
+
+        for (auto& channel : dryInput)
+            std::fill (channel.begin(), channel.end(), 0.0f);
+    }
+
+    // Delay added by the active resampler pair, in base-rate samples.
+    int getLatencySamples() const
+    {
+        const auto* os = getActiveOversampler();
+        return (os != nullptr) ? (int) std::round (os->getLatencyInSamples()) : 0;
+    }
+
+    // Drives left and right (right may be nullptr for a mono output) in place.
+    // mixValues holds a per-sample mix while it ramps, or is nullptr to use mix
+    // for the whole block. The output is then blended back towards the input
+    // by send (per sample in sendValues while it fades) to the input, delayed
+    // by getLatencySamples(), so a closed send leaves exactly what
+    // processAsleep() passes on.
+    void process (float* left, float* right, int numSamples, const float* mixValues, float mix,
+                  const float* sendValues, float send)
+    {
+        if (numSamples > maxBlockSize)
+        {
+            jassertfalse;  // longer than the block size given to prepare()
+            numSamples = maxBlockSize;
+        }
+
+        float* channels[] = { left, right };
+        const int numChannels = (right != nullptr) ? 2 : 1;
+        const int latency = getLatencySamples();
+
+        // at a mix of 0 the plain tier is already the identity
+        const bool blend = quality != Quality::plain && (sendValues != nullptr || send < 1.0f);
+        if (blend || latency > 0)
+            pushDry (channels, numChannels, numSamples, latency);
+
+        if (auto* os = getActiveOversampler())
+        {
+            juce::dsp::AudioBlock<float> block (channels, (size_t) numChannels, (size_t) numSamples);
+            auto upBlock = os->processSamplesUp (block);
+            const int factorLog2 = (quality == Quality::oversampled4x) ? 2 : 1;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                shape (upBlock.getChannelPointer ((size_t) ch), numSamples << factorLog2, mixValues, mix, factorLog2);
+
+            os->processSamplesDown (block);
+        }
+        else if (quality == Quality::antialiased)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                shapeAntialiased (channels[ch], numSamples, mixValues, mix, adaaState[(size_t) ch]);
+        }
+        else
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                shape (channels[ch], numSamples, mixValues, mix, 0);
+        }
+
+        if (blend)
+        {
+            using FVO = juce::FloatVectorOperations;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                // out = in + send * (shaped - in)
+                float* data = channels[ch];
+                const float* in = dryInput[(size_t) ch].data();
+                FVO::subtract (data, in, numSamples);
+
+                if (sendValues != nullptr)
+                    FVO::multiply (data, sendValues, numSamples);
+                else
+                    FVO::multiply (data, send, numSamples);
+
+                FVO::add (data, in, numSamples);
+            }
+        }
+
+        popDry (numChannels, numSamples, latency);
+    }
+
+    // In place of process() while the stage sleeps: delays the signal by
+    // getLatencySamples() and nothing else.
+    void processAsleep (float* left, float* right, int numSamples)
+    {
+        const int latency = getLatencySamples();
+        if (latency == 0)
+            return;
+
+        numSamples = juce::jmin (numSamples, maxBlockSize);
+        float* channels[] = { left, right };
+        const int numChannels = (right != nullptr) ? 2 : 1;
+
+        pushDry (channels, numChannels, numSamples, latency);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::copy (channels[ch], dryInput[(size_t) ch].data(), numSamples);
+
+        popDry (numChannels, numSamples, latency);
+    }
+
+private:
+   #if JUCE_USE_SIMD
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int laneWidth = (int) Lanes::size();
+    static inline Lanes splatLanes (float x)            { return Lanes::expand (x); }
+    static inline Lanes loadLanes (const float* p)      { return Lanes::fromRawArray (p); }
+    static inline void storeLanes (float* p, Lanes v)   { v.copyToRawArray (p); }
+    static inline Lanes absLanes (Lanes v)              { return FastMath::abs (v); }
+   #else
+    using Lanes = float;
+    static constexpr int laneWidth = 1;
+    static inline float splatLanes (float x)            { return x; }
+    static inline float loadLanes (const float* p)      { return *p; }
+    static inline void storeLanes (float* p, float v)   { *p = v; }
+    static inline float absLanes (float v)              { return std::abs (v); }
+   #endif
+
+    // Audio buffers carry no alignment guarantee, so the lanes work on an
+    // aligned copy of up to chunkSize samples at a time.
+    static constexpr int chunkSize = 64;
+    static_assert (chunkSize % laneWidth == 0, "a chunk must fill whole registers");
+
+    // Below this input step the ADAA quotient loses more precision than the
+    // midpoint it is replaced with.
+    static constexpr float adaaMinStep = 1.0e-2f;
+
+    struct AdaaState
+    {
+        float x = 0.0f;      // last dry input
+        float u = 0.0f;      // last driven input
+        float tail = 0.0f;   // logCoshTail (|u|) of it
+    };
+
+    // Appends the block to the latency samples held in dryInput, so its first
+    // numSamples are the input delayed by latency.
+    void pushDry (float* const* channels, int numChannels, int numSamples, int latency)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::copy (dryInput[(size_t) ch].data() + latency, channels[ch], numSamples);
+    }
+
+    // Keeps the last latency inputs for the next block.
+    void popDry (int numChannels, int numSamples, int latency)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* dry = dryInput[(size_t) ch].data();
+            std::copy (dry + numSamples, dry + numSamples + latency, dry);
+        }
+    }
+
+    juce::dsp::Oversampling<float>* getActiveOversampler() const
+    {
+        switch (quality)
+        {
+            case Quality::oversampled2x: return oversamplers[0].get();
+            case Quality::oversampled4x: return oversamplers[1].get();
+            case Quality::plain:
+            case Quality::antialiased:
+            default:                     return nullptr;
+        }
+    }
+
+    // Fills mixOut with the mix of each of n samples starting at start. At an
+    // oversampled rate each base-rate value covers 2^factorLog2 samples.
+    static void loadMix (float* mixOut, int start, int n, const float* mixValues, float mix, int factorLog2)
+    {
+        if (mixValues == nullptr)
+        {
+            std::fill (mixOut, mixOut + chunkSize, mix);
+            return;
+        }
+
+        for (int i = 0; i < n; ++i)
+            mixOut[i] = mixValues[(start + i) >> factorLog2];
+
+        std::fill (mixOut + n, mixOut + chunkSize, 0.0f);
+    }
+
+    // x + (tanh (x * (1 + 10 * mix)) - x) * mix, in place.
+    static void shape (float* data, int numSamples, const float* mixValues, float mix, int factorLog2)
+    {
+        alignas (32) std::array<float, (size_t) chunkSize> xs {};
+        alignas (32) std::array<float, (size_t) chunkSize> ms {};
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int n = juce::jmin (chunkSize, numSamples - start);
+            std::copy (data + start, data + start + n, xs.data());
+            std::fill (xs.data() + n, xs.data() + chunkSize, 0.0f);
+            loadMix (ms.data(), start, n, mixValues, mix, factorLog2);
+
+            for (int k = 0; k < n; k += laneWidth)
+            {
+                const Lanes x = loadLanes (&xs[(size_t) k]);
+                const Lanes m = loadLanes (&ms[(size_t) k]);
+                const Lanes wet = DspMath::tanh (x * (m * 10.0f + 1.0f));
+                storeLanes (&xs[(size_t) k], x + (wet - x) * m);
+            }
+
+            std::copy (xs.data(), xs.data() + n, data + start);
+        }
+    }
+
+    // log cosh (u) = |u| + logCoshTail (|u|) - log 2, where the tail,
+    // log (1 + exp (-2|u|)), stays in [0, log 2]. Differences of log cosh are
+    // taken as a difference of |u| plus a difference of tails, so the large
+    // |u| term never costs the small one its precision.
+    //   log (1 + t) = 2 atanh (s), s = t / (2 + t) in [0, 1/3]; degree 11 < 1e-7
+    template <typename V>
+    static V logCoshTail (V absU) noexcept
+    {
+        const V t = FastMath::exp2 (absU * -2.88539008178f);   // exp (-2|u|)
+        const V s = FastMath::divide (t, t + 2.0f);
+        const V s2 = s * s;
+
+        V p = s2 * (2.0f / 11.0f) + (2.0f / 9.0f);
+        p = p * s2 + (2.0f / 7.0f);
+        p = p * s2 + (2.0f / 5.0f);
+        p = p * s2 + (2.0f / 3.0f);
+        p = p * s2 + 2.0f;
+        return p * s;
+    }
+
+    void shapeAntialiased (float* data, int numSamples, const float* mixValues, float mix, AdaaState& state)
+    {
+        alignas (32) std::array<float, (size_t) chunkSize> us {};
+        alignas (32) std::array<float, (size_t) chunkSize> tails {};
+        alignas (32) std::array<float, (size_t) chunkSize> ms {};
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int n = juce::jmin (chunkSize, numSamples - start);
+            float* x = data + start;
+
+            std::copy (x, x + n, us.data());
+            std::fill (us.data() + n, us.data() + chunkSize, 0.0f);
+            loadMix (ms.data(), start, n, mixValues, mix, 0);
+
+            // the driven input and its log cosh tail, a register at a time
+            for (int k = 0; k < n; k += laneWidth)
+            {
+                const Lanes u = loadLanes (&us[(size_t) k]) * (loadLanes (&ms[(size_t) k]) * 10.0f + 1.0f);
+                storeLanes (&us[(size_t) k], u);
+                storeLanes (&tails[(size_t) k], logCoshTail (absLanes (u)));
+            }
+
+            // the quotients depend on the previous sample, so they run in order
+            for (int i = 0; i < n; ++i)
+            {
+                const float u = us[(size_t) i];
+                const float du = u - state.u;
+                const float wet = (std::abs (du) > adaaMinStep)
+                                ? ((std::abs (u) - std::abs (state.u)) + (tails[(size_t) i] - state.tail)) / du
+                                : DspMath::tanh (0.5f * (u + state.u));
+
+                const float dry = 0.5f * (x[i] + state.x);
+                state.x = x[i];
+                state.u = u;
+                state.tail = tails[(size_t) i];
+
+                x[i] = dry + (wet - dry) * ms[(size_t) i];
+            }
+        }
+    }
+
+    Quality quality = Quality::plain;
+    int maxBlockSize = 1;
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2> oversamplers;
+    std::array<AdaaState, 2> adaaState {};
+    std::array<std::vector<float>, 2> dryInput;   // latency held samples, then the block
+};
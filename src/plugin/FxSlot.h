@@ -0,0 +1,122 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterRamp.h"
+#include <array>
+#include <vector>
+
+//==============================================================================
+// Bypass state for one FX stage, so switching it off or on never clicks and
+// never chops a tail:
+//   active   - the stage is wanted; it runs with its send fully open.
+//   tailing  - no longer wanted: the send fades to zero, but the stage keeps
+//              running so its tail rings out, until what it adds to the signal
+//              stays below silenceThreshold for a whole block.
+//   sleeping - skipped entirely. end() reports the switch so the caller can
+//              clear the stage's buffers; waking fades the send back in.
+// A stage wanted again while tailing just fades its send back in.
+class FxSlot
+{
+public:
+    enum class State
+    {
+        sleeping,
+        active,
+        tailing
+    };
+
+    // The level (about -80 dB) below which a tail counts as gone; the same
+    // as AcidVoice::idleThreshold.
+    static constexpr float silenceThreshold = 1.0e-4f;
+
+    void prepare (double sampleRate, int maximumBlockSize)
+    {
+        send.prepare (sampleRate, 0.02, maximumBlockSize);
+        send.setCurrentAndTargetValue (0.0f);
+        state = State::sleeping;
+
+        for (auto& channel : dryInput)
+            channel.assign ((size_t) juce::jmax (1, maximumBlockSize), 0.0f);
+    }
+
+    State getState() const noexcept { return state; }
+
+    // Call once per block before the stage. Returns false if the stage should
+    // be skipped. right may be nullptr for a mono output.
+    bool begin (bool wanted, const float* left, const float* right, int numSamples)
+    {
+        if (wanted)
+        {
+            state = State::active;
+            send.setTargetValue (1.0f);
+        }
+        else if (state == State::active)
+        {
+            state = State::tailing;
+            send.setTargetValue (0.0f);
+        }
+
+        if (state == State::sleeping)
+            return false;
+
+        sendValues = send.process (numSamples);
+
+        // the stage's own contribution is measured against its input while tailing
+        if (state == State::tailing && numSamples <= (int) dryInput[0].size())
+        {
+            juce::FloatVectorOperations::copy (dryInput[0].data(), left, numSamples);
+            if (right != nullptr)
+                juce::FloatVectorOperations::copy (dryInput[1].data(), right, numSamples);
+        }
+
+        return true;
+    }
+
+    // Per-sample send gain (0..1) for this block while it fades, else nullptr
+    // and getSend() holds for the whole block. Stages whose own mix control
+    // already fades them can ignore it.
+    const float* getSendValues() const noexcept { return sendValues; }
+    float getSend() const noexcept              { return send.getTargetValue(); }
+
+    // Call after the stage ran. Returns true if the slot has just gone to
+    // sleep, i.e. the caller should now clear the stage's buffers.
+    bool end (const float* left, const float* right, int numSamples)
+    {
+        if (state != State::tailing || send.isSmoothing() || numSamples > (int) dryInput[0].size())
+            return false;
+
+        if (addedPeak (left, dryInput[0].data(), numSamples) >= silenceThreshold)
+            return false;
+
+        if (right != nullptr && addedPeak (right, dryInput[1].data(), numSamples) >= silenceThreshold)
+            return false;
+
+        state = State::sleeping;
+        return true;
+    }
+
+    // end() for a stage with no tail of its own, whose output once the send
+    // has closed is its input (or a fixed delay of it): it sleeps as soon as
+    // the send fade is done.
+    bool end() noexcept
+    {
+        if (state != State::tailing || send.isSmoothing())
+            return false;
+
+        state = State::sleeping;
+        return true;
+    }
+
+private:
+    // Largest |out - in| over the block; dry is overwritten.
+    static float addedPeak (const float* out, float* dry, int numSamples)
+    {
+        juce::FloatVectorOperations::subtract (dry, out, numSamples);
+        const auto range = juce::FloatVectorOperations::findMinAndMax (dry, numSamples);
+        return juce::jmax (-range.getStart(), range.getEnd());
+    }
+
+    State state = State::sleeping;
+    ParameterRamp send;
+    const float* sendValues = nullptr;
+    std::array<std::vector<float>, 2> dryInput;
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+
+//==============================================================================
+// The notes currently held on a mono voice, in the order they were pressed.
+// Storage is fixed (one slot per MIDI note), so pushing, removing and
+// clearing never allocate and are O(1):
+//   - a doubly linked list threaded through the slots keeps the press order,
+//   - a 128-bit bitmap records which notes are held, which also answers
+//     "lowest / highest held note" with a few word scans.
+class HeldNoteStack
+{
+public:
+    enum class Priority
+    {
+        last,
+        low,
+        high
+    };
+
+    static constexpr int numNotes = 128;
+
+    void clear() noexcept
+    {
+        held = {};
+        newest = none;
+        size = 0;
+    }
+
+    bool isEmpty() const noexcept { return size == 0; }
+    int getSize() const noexcept  { return size; }
+
+    bool contains (int note) const noexcept
+    {
+        return juce::isPositiveAndBelow (note, numNotes) && isHeld (note);
+    }
+
+    // Adds a note as the most recent one; a note that is already held moves
+    // to the top and takes the new velocity.
+    void push (int note, float velocity) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (note, numNotes));
+        if (! juce::isPositiveAndBelow (note, numNotes))
+            return;
+
+        if (isHeld (note))
+            unlink (note);
+
+        const auto n = (size_t) note;
+        velocities[n] = velocity;
+        older[n] = newest;
+        newer[n] = none;
+
+        if (newest != none)
+            newer[(size_t) newest] = (int8_t) note;
+
+        newest = (int8_t) note;
+        held[n >> 5] |= 1u << (n & 31);
+        ++size;
+    }
+
+    void remove (int note) noexcept
+    {
+        if (contains (note))
+            unlink (note);
+    }
+
+    // The note that should sound under the given priority, or -1 if none is held.
+    int getNote (Priority priority) const noexcept
+    {
+        switch (priority)
+        {
+            case Priority::low:  return findLowest();
+            case Priority::high: return findHighest();
+            case Priority::last:
+            default:             return newest;
+        }
+    }
+
+    float getVelocity (int note) const noexcept
+    {
+        return contains (note) ? velocities[(size_t) note] : 0.0f;
+    }
+
+private:
+    static constexpr int8_t none = -1;
+    static constexpr int numWords = numNotes / 32;
+
+    bool isHeld (int note) const noexcept
+    {
+        return (held[(size_t) note >> 5] & (1u << ((uint32_t) note & 31))) != 0;
+    }
+
+    void unlink (int note) noexcept
+    {
+        const auto n = (size_t) note;
+        const int8_t before = older[n];
+        const int8_t after = newer[n];
+
+        if (before != none)
+            newer[(size_t) before] = after;
+
+        if (after != none)
+            older[(size_t) after] = before;
+        else
+            newest = before;
+
+        held[n >> 5] &= ~(1u << (n & 31));
+        --size;
+    }
+
+    int findLowest() const noexcept
+    {
+        for (int w = 0; w < numWords; ++w)
+            if (const uint32_t bits = held[(size_t) w])
+                return w * 32 + juce::findHighestSetBit (bits & (~bits + 1u)); // isolate the lowest set bit
+
+        return -1;
+    }
+
+    int findHighest() const noexcept
+    {
+        for (int w = numWords; --w >= 0;)
+            if (const uint32_t bits = held[(size_t) w])
+                return w * 32 + juce::findHighestSetBit (bits);
+
+        return -1;
+    }
+
+    std::array<float, (size_t) numNotes> velocities {};
+    std::array<int8_t, (size_t) numNotes> older {};   // next note down the stack (pressed earlier)
+    std::array<int8_t, (size_t) numNotes> newer {};   // next note up the stack (pressed later)
+    std::array<uint32_t, (size_t) numWords> held {};
+    int8_t newest = none;
+    int size = 0;
+};
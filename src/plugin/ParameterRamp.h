@@ -0,0 +1,83 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+// Linear smoothing for a continuous control, produced a block at a time.
+// While the value is settled process() returns nullptr and the caller keeps
+// using getTargetValue(), so static controls cost nothing per sample. While
+// it moves, process() writes the block's per-sample values with
+// FloatVectorOperations and returns them.
+class ParameterRamp
+{
+public:
+    // Allocates the ramp buffer. A block longer than maximumBlockSize (which a
+    // host should not send) makes the ramp jump straight to its target.
+    void prepare (double sampleRate, double rampSeconds, int maximumBlockSize)
+    {
+        rampLength = juce::jmax (1, juce::roundToInt (sampleRate * rampSeconds));
+
+        const auto size = (size_t) juce::jmax (1, maximumBlockSize);
+        values.assign (size, 0.0f);
+        offsets.resize (size);
+        for (size_t i = 0; i < size; ++i)
+            offsets[i] = (float) (i + 1);
+
+        setCurrentAndTargetValue (target);
+    }
+
+    void setCurrentAndTargetValue (float newValue) noexcept
+    {
+        current = target = newValue;
+        countdown = 0;
+    }
+
+    void setTargetValue (float newValue) noexcept
+    {
+        if (newValue == target)
+            return;
+
+        target = newValue;
+        countdown = rampLength;
+        step = (target - current) / (float) countdown;
+    }
+
+    bool isSmoothing() const noexcept     { return countdown > 0; }
+    float getTargetValue() const noexcept { return target; }
+
+    // Advances the ramp by numSamples. Returns the value of each of those
+    // samples, or nullptr if it is settled at getTargetValue() for all of them.
+    const float* process (int numSamples) noexcept
+    {
+        if (countdown <= 0)
+            return nullptr;
+
+        jassert (numSamples <= (int) values.size());
+        if (numSamples > (int) values.size())
+        {
+            setCurrentAndTargetValue (target);
+            return nullptr;
+        }
+
+        const int n = juce::jmin (countdown, numSamples);
+        juce::FloatVectorOperations::copyWithMultiply (values.data(), offsets.data(), step, n);
+        juce::FloatVectorOperations::add (values.data(), current, n);
+
+        countdown -= n;
+        current = (countdown > 0) ? current + step * (float) n : target;
+
+        if (n < numSamples)
+            juce::FloatVectorOperations::fill (values.data() + n, target, numSamples - n);
+
+        return values.data();
+    }
+
+private:
+    std::vector<float> values;
+    std::vector<float> offsets;  // 1, 2, 3, ... so a ramp is one multiply-add
+    float current = 0.0f;
+    float target = 0.0f;
+    float step = 0.0f;
+    int rampLength = 1;
+    int countdown = 0;
+};
@@ -22,6 +22,8 @@ namespace
 
 AcidSynthAudioProcessorEditor::~AcidSynthAudioProcessorEditor()
 {
+    stopTimer();
+
     for (auto* s : { &wave, &cutoff, &res, &envmod, &decay, &release, &accent, &glide, &drive, &sat, &sub, &unison,
                      &unisonSpread, &gain, &volume, &lfo1Rate, &lfo2Rate, &modEnvDecay, &mod1Amount, &mod2Amount, &mod3Amount,
                      &fxDrive, &fxChorus, &fxDelay, &fxDelayTime, &fxReverb })
@@ -340,6 +342,7 @@ AcidSynthAudioProcessorEditor::AcidSynthAudioProcessorEditor (AcidSynthAudioProc
     keyboard.setColour (juce::MidiKeyboardComponent::textLabelColourId, kTextMuted);
     keyboard.setColour (juce::MidiKeyboardComponent::mouseOverKeyOverlayColourId, kAccent.withAlpha (0.18f));
     keyboard.setColour (juce::MidiKeyboardComponent::keyDownOverlayColourId, kAccent.withAlpha (0.45f));
+    startTimerHz (30);
 
     // --- Top bar labels
     titleLabel.setText ("Acid Ladder VST", juce::dontSendNotification);
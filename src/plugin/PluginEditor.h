@@ -2,7 +2,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
-class AcidSynthAudioProcessorEditor : public juce::AudioProcessorEditor
+class AcidSynthAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                      private juce::Timer
 {
 public:
     explicit AcidSynthAudioProcessorEditor (AcidSynthAudioProcessor&);
@@ -14,6 +15,9 @@ public:
 private:
     AcidSynthAudioProcessor& processor;
 
+    // lights the keys the host is playing
+    void timerCallback() override { processor.updateKeyboardDisplay(); }
+
     struct KnobLookAndFeel : juce::LookAndFeel_V4
     {
         void drawRotarySlider (juce::Graphics& g, int x, int y, int width, int height,
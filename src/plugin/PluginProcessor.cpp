@@ -5,6 +5,10 @@ namespace
 {
     constexpr double kFallbackBpm = 120.0;
 
+    // longest delay the FX delay can be synced to (a whole note at 120 BPM);
+    // the free-running Delay Time tops out at 700 ms
+    constexpr double kMaxDelaySeconds = 2.0;
+
     double getHostBpm (juce::AudioPlayHead* playHead)
     {
         if (playHead != nullptr)
@@ -45,6 +49,37 @@ namespace
 
         return static_cast<float> (1.0 / periodSeconds);
     }
+
+    int getControlRateInterval (int modRateIndex)
+    {
+        switch (modRateIndex)
+        {
+            case 0: return 1;   // audio rate
+            case 1: return 8;
+            case 2: return 16;
+            case 3: return 32;
+            default: return 16;
+        }
+    }
+
+    // Oversampling choice index (1x/2x/4x/8x) to a power of two; offline renders
+    // run at least 4x since there is no real-time budget to protect.
+    int getOversamplingLog2 (int oversamplingIndex, bool isOffline)
+    {
+        constexpr int offlineMinimumLog2 = 2;
+        const int selected = juce::jlimit (0, AcidVoice::maxOversamplingLog2, oversamplingIndex);
+        return isOffline ? juce::jmax (selected, offlineMinimumLog2) : selected;
+    }
+
+    // Time for a feedback loop with the given period and gain to fall by 80 dB
+    // (AcidVoice::idleThreshold), including the first pass through it.
+    double getFeedbackTailSeconds (double periodSeconds, double feedback)
+    {
+        if (feedback <= 0.0)
+            return periodSeconds;
+
+        return periodSeconds * (1.0 + std::log ((double) AcidVoice::idleThreshold) / std::log (feedback));
+    }
 }
 
 /*
@@ -56,22 +91,217 @@ Manual test procedure (Acid 303 Accent + Slide):
 5) Turn Accent/Cutoff/Res during sustain -> no clicks or zipper noise.
 */
 
-static float getParam (juce::AudioProcessorValueTreeState& apvts, const char* id)
+static std::atomic<float>* getParamPointer (juce::AudioProcessorValueTreeState& apvts, const char* id)
 {
-    if (auto* v = apvts.getRawParameterValue (id))
-        return v->load();
-
-    jassertfalse; // param id typo
-    return 0.0f;
+    auto* v = apvts.getRawParameterValue (id);
+    jassert (v != nullptr); // param id typo
+    return v;
 }
 
 AcidSynthAudioProcessor::AcidSynthAudioProcessor()
     : juce::AudioProcessor (BusesProperties().withOutput ("Output", juce::AudioChannelSet::stereo(), true))
     , apvts (*this, nullptr, "PARAMS", createParams())
 {
+    params.wave = getParamPointer (apvts, "wave");
+    params.cutoff = getParamPointer (apvts, "cutoff");
+    params.res = getParamPointer (apvts, "res");
+    params.filterChar = getParamPointer (apvts, "filterChar");
+    params.envmod = getParamPointer (apvts, "envmod");
+    params.decay = getParamPointer (apvts, "decay");
+    params.release = getParamPointer (apvts, "release");
+    params.accent = getParamPointer (apvts, "accent");
+    params.glide = getParamPointer (apvts, "glide");
+    params.drive = getParamPointer (apvts, "drive");
+    params.sat = getParamPointer (apvts, "sat");
+    params.sub = getParamPointer (apvts, "sub");
+    params.unison = getParamPointer (apvts, "unison");
+    params.unisonSpread = getParamPointer (apvts, "unisonSpread");
+    params.unisonVoices = getParamPointer (apvts, "unisonVoices");
+    params.gain = getParamPointer (apvts, "gain");
+    params.volume = getParamPointer (apvts, "volume");
+
+    params.lfo1Mode = getParamPointer (apvts, "lfo1Mode");
+    params.lfo1Sync = getParamPointer (apvts, "lfo1Sync");
+    params.lfo1Rate = getParamPointer (apvts, "lfo1Rate");
+    params.lfo2Mode = getParamPointer (apvts, "lfo2Mode");
+    params.lfo2Sync = getParamPointer (apvts, "lfo2Sync");
+    params.lfo2Rate = getParamPointer (apvts, "lfo2Rate");
+    params.modEnvDecay = getParamPointer (apvts, "modEnvDecay");
+    params.modRate = getParamPointer (apvts, "modRate");
+    params.oversampling = getParamPointer (apvts, "oversampling");
+    params.voiceMode = getParamPointer (apvts, "voiceMode");
+    params.notePriority = getParamPointer (apvts, "notePriority");
+    params.panLaw = getParamPointer (apvts, "panLaw");
+    params.polyVoices = getParamPointer (apvts, "polyVoices");
+    params.multiCore = getParamPointer (apvts, "multiCore");
+
+    params.modSource = { getParamPointer (apvts, "mod1Source"), getParamPointer (apvts, "mod2Source"), getParamPointer (apvts, "mod3Source") };
+    params.modDest = { getParamPointer (apvts, "mod1Dest"), getParamPointer (apvts, "mod2Dest"), getParamPointer (apvts, "mod3Dest") };
+    params.modAmount = { getParamPointer (apvts, "mod1Amount"), getParamPointer (apvts, "mod2Amount"), getParamPointer (apvts, "mod3Amount") };
+
+    params.fxDrive = getParamPointer (apvts, "fxDrive");
+    params.fxChorus = getParamPointer (apvts, "fxChorus");
+    params.fxDelay = getParamPointer (apvts, "fxDelay");
+    params.fxDelayTime = getParamPointer (apvts, "fxDelayTime");
+    params.fxDelayMode = getParamPointer (apvts, "fxDelayMode");
+    params.fxDelaySync = getParamPointer (apvts, "fxDelaySync");
+    params.fxDelayPingPong = getParamPointer (apvts, "fxDelayPingPong");
+    params.fxReverb = getParamPointer (apvts, "fxReverb");
+    params.fxReverbQuality = getParamPointer (apvts, "fxReverbQuality");
+    params.fxDriveQuality = getParamPointer (apvts, "fxDriveQuality");
+    params.fxOrder = getParamPointer (apvts, "fxOrder");
+
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            apvts.addParameterListener (ranged->paramID, this);
+
+    keyboardState.addListener (this);
+}
+
+AcidSynthAudioProcessor::~AcidSynthAudioProcessor()
+{
+    cancelPendingUpdate();
+    keyboardState.removeListener (this);
+
+    for (auto* parameter : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            apvts.removeParameterListener (ranged->paramID, this);
+}
+
+void AcidSynthAudioProcessor::parameterChanged (const juce::String& parameterID, float)
+{
+    parameterGeneration.fetch_add (1, std::memory_order_release);
+
+    if (parameterID == "multiCore")
+        triggerAsyncUpdate();
+}
+
+void AcidSynthAudioProcessor::handleAsyncUpdate()
+{
+    updateRenderWorkers();
+}
+
+// Message thread: keeps the worker threads running only while Multi-Core is
+// on, so with it off they cost nothing at all.
+void AcidSynthAudioProcessor::updateRenderWorkers()
+{
+    const bool wanted = renderWorkerBlockSize > 0 && params.multiCore->load() > 0.5f;
+    if (wanted == (renderWorkers.getNumWorkers() > 0))
+        return;
+
+    if (wanted)
+        renderWorkers.start (juce::SystemStats::getNumCpus() - 1, renderWorkerSampleRate, renderWorkerBlockSize);
+    else
+        renderWorkers.stop();
+}
+
+// Pushes every voice setting and recomputes the FX tail; only called when
+// something they depend on changed.
+void AcidSynthAudioProcessor::applyParameterChanges (double bpm)
+{
+    appliedGeneration = parameterGeneration.load (std::memory_order_acquire);
+    appliedBpm = bpm;
+    appliedOffline = isNonRealtime();
+    const auto& p = params;
+    voice.setParams (p.wave->load(), p.cutoff->load(), p.res->load(), p.envmod->load(),
+                     p.decay->load(), p.release->load(), p.accent->load(), p.glide->load(),
+                     p.drive->load(), p.sat->load(), p.sub->load(),
+                     p.unison->load(), p.unisonSpread->load(), p.gain->load(),
+                     (int) p.filterChar->load());
+    voice.setUnisonVoices ((int) p.unisonVoices->load());
+
+    const float lfo1TargetRate = ((int) p.lfo1Mode->load() == 0) ? p.lfo1Rate->load()
+                                                                 : getSyncedLfoRateHz (bpm, (int) p.lfo1Sync->load());
+    const float lfo2TargetRate = ((int) p.lfo2Mode->load() == 0) ? p.lfo2Rate->load()
+                                                                 : getSyncedLfoRateHz (bpm, (int) p.lfo2Sync->load());
+
+    voice.setModMatrix ((int) p.modSource[0]->load(), (int) p.modDest[0]->load(), p.modAmount[0]->load(),
+                        (int) p.modSource[1]->load(), (int) p.modDest[1]->load(), p.modAmount[1]->load(),
+                        (int) p.modSource[2]->load(), (int) p.modDest[2]->load(), p.modAmount[2]->load(),
+                        lfo1TargetRate, lfo2TargetRate, p.modEnvDecay->load());
+    voice.setControlRate (getControlRateInterval ((int) p.modRate->load()));
+    voice.setOversampling (getOversamplingLog2 ((int) p.oversampling->load(), appliedOffline));
+    voice.setVoiceMode ((int) p.voiceMode->load() == 1, (int) p.polyVoices->load());
+    voice.setNotePriority ((int) p.notePriority->load());
+    voice.setPanLaw ((int) p.panLaw->load());
+    voice.setRenderWorkers (p.multiCore->load() > 0.5f ? &renderWorkers : nullptr);
+
+    fxChain.setOrder ((int) p.fxOrder->load());
+    drive.setQuality ((FxDrive::Quality) juce::jlimit (0, 3, (int) p.fxDriveQuality->load()));
+    reverb.setQuality ((FdnReverb::Quality) juce::jlimit (0, 2, (int) p.fxReverbQuality->load()));
+
+    updateFxTail();
+}
+
+// Recomputes fxTailSamples and the reported tail length for the current
+// settings and slot states.
+void AcidSynthAudioProcessor::updateFxTail()
+{
+    fxTailSlotStates = fxChain.getSlotStates();
+
+    const double fxTailSeconds = getFxTailSeconds();
+    // plus what the drive's delay line still holds
+    fxTailSamples = (int) std::ceil (fxTailSeconds * getSampleRate()) + drive.getLatencySamples();
+    tailLengthSeconds.store (voice.getReleaseTailSeconds() + fxTailSeconds, std::memory_order_relaxed);
+}
+
+// The voice's resamplers plus the FX drive's, both in base-rate samples.
+int AcidSynthAudioProcessor::getTotalLatencySamples() const
+{
+    return voice.getLatencySamples() + drive.getLatencySamples();
 }
 
-AcidSynthAudioProcessor::~AcidSynthAudioProcessor() = default;
+// How long the FX keep ringing after their input goes silent; mirrors the
+// settings processBlock gives them. A stage counts while it is switched on or
+// its slot is still running: a closed send leaves the delay lines and the
+// room ringing. The stages run in series, each ringing into the next, so
+// their tails add up whatever the order. Audio thread only (it reads the
+// slot states).
+double AcidSynthAudioProcessor::getFxTailSeconds() const
+{
+    double tail = 0.0;
+
+    auto isRunning = [this] (FxChain::Stage stage, float mix)
+    {
+        return mix > 0.0001f || fxChain.getSlot (stage).getState() != FxSlot::State::sleeping;
+    };
+
+    const float chorusMix = juce::jlimit (0.0f, 1.0f, params.fxChorus->load());
+    if (isRunning (FxChain::chorus, chorusMix))
+        tail += getFeedbackTailSeconds (0.032, 0.18);   // 12 ms centre + 20 ms modulation
+
+    const float delayMix = juce::jlimit (0.0f, 1.0f, params.fxDelay->load());
+    if (isRunning (FxChain::delay, delayMix))
+        tail += getFeedbackTailSeconds (getDelayTimeMs (appliedBpm) * 0.001, StereoDelay::getFeedback (delayMix));
+
+    const float reverbMix = juce::jlimit (0.0f, 1.0f, params.fxReverb->load());
+    if (isRunning (FxChain::reverb, reverbMix))
+    {
+        // a room ringing out keeps its last size (see processFxStage)
+        const float roomSize = (reverbMix > 0.0001f) ? 0.2f + 0.7f * reverbMix : reverb.getParameters().roomSize;
+        const double fallSeconds = FdnReverb::getDecaySeconds (roomSize) * std::log10 ((double) AcidVoice::idleThreshold) / -3.0;
+        tail += FdnReverb::getLongestLineSeconds() + fallSeconds;
+    }
+
+    return tail;
+}
+
+// The FX delay time: the Delay Time knob, or a note length at the host tempo.
+float AcidSynthAudioProcessor::getDelayTimeMs (double bpm) const
+{
+    if ((int) params.fxDelayMode->load() == 0)
+        return params.fxDelayTime->load();
+
+    const double safeBpm = (bpm > 0.0) ? bpm : kFallbackBpm;
+    const double seconds = 60.0 / safeBpm * getSyncPeriodMultiplier ((int) params.fxDelaySync->load());
+    return (float) (1000.0 * juce::jmin (seconds, kMaxDelaySeconds));
+}
+
+// Published by applyParameterChanges(), since hosts ask from any thread.
+double AcidSynthAudioProcessor::getTailLengthSeconds() const
+{
+    return tailLengthSeconds.load (std::memory_order_relaxed);
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout AcidSynthAudioProcessor::createParams()
 {
@@ -124,6 +354,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout AcidSynthAudioProcessor::cre
     p.push_back (std::make_unique<AudioParameterFloat> ("unisonSpread", "Unison Spread",
                                                         NormalisableRange<float>(0.0f, 1.0f), 0.2f));
 
+    p.push_back (std::make_unique<AudioParameterInt> ("unisonVoices", "Unison Voices", 1, AcidVoice::maxUnisonVoices, 3));
+
     p.push_back (std::make_unique<AudioParameterFloat> ("gain",   "Gain",
                                                         NormalisableRange<float>(0.0f, 1.5f), 0.85f));
 
@@ -146,6 +378,21 @@ juce::AudioProcessorValueTreeState::ParameterLayout AcidSynthAudioProcessor::cre
     p.push_back (std::make_unique<AudioParameterFloat> ("modEnvDecay", "Mod Env Decay",
                                                         NormalisableRange<float>(0.0f, 2.5f, 0.0f, 0.4f), 0.55f));
 
+    p.push_back (std::make_unique<AudioParameterChoice> ("modRate", "Mod Rate",
+                                                         StringArray { "Audio", "8 Samples", "16 Samples", "32 Samples" }, 2));
+
+    p.push_back (std::make_unique<AudioParameterChoice> ("oversampling", "Oversampling",
+                                                         StringArray { "1x", "2x", "4x", "8x" }, 0));
+
+    p.push_back (std::make_unique<AudioParameterChoice> ("voiceMode", "Voice Mode",
+                                                         StringArray { "Mono", "Poly" }, 0));
+    p.push_back (std::make_unique<AudioParameterChoice> ("notePriority", "Note Priority",
+                                                         StringArray { "Last", "Low", "High" }, 0));
+    p.push_back (std::make_unique<AudioParameterChoice> ("panLaw", "Pan Law",
+                                                         StringArray { "-3 dB", "-4.5 dB", "-6 dB" }, 0));
+    p.push_back (std::make_unique<AudioParameterInt> ("polyVoices", "Poly Voices", 8, AcidVoice::maxPolyVoices, 8));
+    p.push_back (std::make_unique<AudioParameterBool> ("multiCore", "Multi-Core", false));
+
     p.push_back (std::make_unique<AudioParameterChoice> ("mod1Source", "Mod 1 Source", modSources, 0));
     p.push_back (std::make_unique<AudioParameterChoice> ("mod1Dest", "Mod 1 Dest", modDests, 0));
     p.push_back (std::make_unique<AudioParameterFloat> ("mod1Amount", "Mod 1 Amount",
@@ -163,6 +410,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout AcidSynthAudioProcessor::cre
 
     p.push_back (std::make_unique<AudioParameterFloat> ("fxDrive", "FX Drive",
                                                         NormalisableRange<float>(0.0f, 1.0f), 0.15f));
+    p.push_back (std::make_unique<AudioParameterChoice> ("fxDriveQuality", "Drive Quality",
+                                                         StringArray { "1x", "1x ADAA", "2x", "4x" }, 0));
 
     p.push_back (std::make_unique<AudioParameterFloat> ("fxChorus", "Chorus",
                                                         NormalisableRange<float>(0.0f, 1.0f), 0.18f));
@@ -172,9 +421,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout AcidSynthAudioProcessor::cre
 
     p.push_back (std::make_unique<AudioParameterFloat> ("fxDelayTime", "Delay Time",
                                                         NormalisableRange<float>(5.0f, 700.0f, 0.0f, 0.5f), 260.0f));
+    p.push_back (std::make_unique<AudioParameterChoice> ("fxDelayMode", "Delay Mode", lfoModes, 0));
+    p.push_back (std::make_unique<AudioParameterChoice> ("fxDelaySync", "Delay Sync", lfoSyncs, 6));
+    p.push_back (std::make_unique<AudioParameterBool> ("fxDelayPingPong", "Ping-Pong", false));
 
     p.push_back (std::make_unique<AudioParameterFloat> ("fxReverb", "Reverb",
                                                         NormalisableRange<float>(0.0f, 1.0f), 0.25f));
+    p.push_back (std::make_unique<AudioParameterChoice> ("fxReverbQuality", "Reverb Quality",
+                                                         StringArray { "Economy", "Standard", "High" }, 1));
+
+    p.push_back (std::make_unique<AudioParameterChoice> ("fxOrder", "FX Order", FxChain::getOrderNames(), 0));
 
     return { p.begin(), p.end() };
 }
@@ -187,7 +443,16 @@ bool AcidSynthAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 
 void AcidSynthAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    voice.prepare (sampleRate);
+    voice.prepare (sampleRate, samplesPerBlock);
+    drive.prepare (samplesPerBlock);
+    applyParameterChanges (getHostBpm (getPlayHead()));
+    setLatencySamples (getTotalLatencySamples());
+
+    // restarted for the new block size, if Multi-Core is on
+    renderWorkers.stop();
+    renderWorkerBlockSize = samplesPerBlock;
+    renderWorkerSampleRate = sampleRate;
+    updateRenderWorkers();
 
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
@@ -198,195 +463,368 @@ void AcidSynthAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBl
     chorus.setCentreDelay (12.0f);
     chorus.setFeedback (0.18f);
 
-    delayLineL.reset();
-    delayLineR.reset();
-    delayLineL.prepare (spec);
-    delayLineR.prepare (spec);
+    delay.prepare (sampleRate, kMaxDelaySeconds, samplesPerBlock);
+    delay.setDelayTimeMs (getDelayTimeMs (appliedBpm), false);
+
+    reverb.prepare (sampleRate, samplesPerBlock);
+
+    fxChain.prepare (sampleRate, samplesPerBlock);
 
-    reverb.reset();
+    volumeRamp.prepare (sampleRate, 0.02, samplesPerBlock);
+    fxDriveRamp.prepare (sampleRate, 0.02, samplesPerBlock);
+    fxDelayRamp.prepare (sampleRate, 0.02, samplesPerBlock);
+    volumeRamp.setCurrentAndTargetValue (params.volume->load());
+    fxDriveRamp.setCurrentAndTargetValue (juce::jlimit (0.0f, 1.0f, params.fxDrive->load()));
+    fxDelayRamp.setCurrentAndTargetValue (juce::jlimit (0.0f, 1.0f, params.fxDelay->load()));
 }
 
 void AcidSynthAudioProcessor::releaseResources()
 {
+    voice.setRenderWorkers (nullptr);
+    renderWorkers.stop();
+    renderWorkerBlockSize = 0;
 }
 
-void AcidSynthAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+void AcidSynthAudioProcessor::handleMidiEvent (const juce::MidiMessage& msg)
 {
-    juce::ScopedNoDenormals noDenormals;
-    buffer.clear();
+    if (msg.isNoteOn())
+    {
+        voice.noteOn (msg.getNoteNumber(), msg.getFloatVelocity());
+        hostNotes.push ({ 0.0, (int8_t) msg.getNoteNumber(), msg.getFloatVelocity() });
+    }
+    else if (msg.isNoteOff())
+    {
+        voice.noteOff (msg.getNoteNumber());
+        hostNotes.push ({ 0.0, (int8_t) msg.getNoteNumber(), 0.0f });
+    }
+    else if (msg.isChannelPressure())
+        voice.setAftertouch (msg.getChannelPressureValue() / 127.0f);
+    else if (msg.isAftertouch())
+        voice.setAftertouch (msg.getAfterTouchValue() / 127.0f);
+    else if (msg.isAllNotesOff() || msg.isAllSoundOff())
+    {
+        voice.reset();
+        hostNotes.pushAllNotesOff (0.0);
+    }
+}
 
-    // ✅ THIS is the critical line that makes the on-screen keyboard generate MIDI:
-    keyboardState.processNextMidiBuffer (midi, 0, buffer.getNumSamples(), true);
-
-    // parameters
-    const float wave   = getParam (apvts, "wave");
-    const float cutoff = getParam (apvts, "cutoff");
-    const float res    = getParam (apvts, "res");
-    const int filterChar = (int) getParam (apvts, "filterChar");
-    const float envmod = getParam (apvts, "envmod");
-    const float decay  = getParam (apvts, "decay");
-    const float release = getParam (apvts, "release");
-    const float accent = getParam (apvts, "accent");
-    const float glide  = getParam (apvts, "glide");
-    const float drive  = getParam (apvts, "drive");
-    const float sat    = getParam (apvts, "sat");
-    const float subMix = getParam (apvts, "sub");
-    const float unison = getParam (apvts, "unison");
-    const float unisonSpread = getParam (apvts, "unisonSpread");
-    const float gain   = getParam (apvts, "gain");
-    const float volume = getParam (apvts, "volume");
-
-    const int lfo1Mode = (int) getParam (apvts, "lfo1Mode");
-    const int lfo1Sync = (int) getParam (apvts, "lfo1Sync");
-    const float lfo1Rate = getParam (apvts, "lfo1Rate");
-    const int lfo2Mode = (int) getParam (apvts, "lfo2Mode");
-    const int lfo2Sync = (int) getParam (apvts, "lfo2Sync");
-    const float lfo2Rate = getParam (apvts, "lfo2Rate");
-    const float modEnvDecay = getParam (apvts, "modEnvDecay");
-
-    const int mod1Source = (int) getParam (apvts, "mod1Source");
-    const int mod1Dest = (int) getParam (apvts, "mod1Dest");
-    const float mod1Amount = getParam (apvts, "mod1Amount");
-
-    const int mod2Source = (int) getParam (apvts, "mod2Source");
-    const int mod2Dest = (int) getParam (apvts, "mod2Dest");
-    const float mod2Amount = getParam (apvts, "mod2Amount");
-
-    const int mod3Source = (int) getParam (apvts, "mod3Source");
-    const int mod3Dest = (int) getParam (apvts, "mod3Dest");
-    const float mod3Amount = getParam (apvts, "mod3Amount");
-
-    const float fxDrive = getParam (apvts, "fxDrive");
-    const float fxChorus = getParam (apvts, "fxChorus");
-    const float fxDelay = getParam (apvts, "fxDelay");
-    const float fxDelayTime = getParam (apvts, "fxDelayTime");
-    const float fxReverb = getParam (apvts, "fxReverb");
+// Mirrors the host's notes on keyboardState so they light up the on-screen
+// keys. The listener callbacks below ignore them, as the voice already has
+// them.
+void AcidSynthAudioProcessor::updateKeyboardDisplay()
+{
+    const juce::ScopedValueSetter<bool> showing (showingHostNotes, true);
 
-    const double bpm = getHostBpm (getPlayHead());
-    const float lfo1TargetRate = (lfo1Mode == 0) ? lfo1Rate : getSyncedLfoRateHz (bpm, lfo1Sync);
-    const float lfo2TargetRate = (lfo2Mode == 0) ? lfo2Rate : getSyncedLfoRateHz (bpm, lfo2Sync);
+    hostNotes.popAll ([this] (const UiNoteQueue::Event& event)
+    {
+        if (event.velocity > 0.0f)
+            keyboardState.noteOn (1, event.note, event.velocity);
+        else
+            keyboardState.noteOff (1, event.note, 0.0f);
+    });
+}
 
-    voice.setParams (wave, cutoff, res, envmod, decay, release, accent, glide, drive, sat, subMix, unison, unisonSpread, gain, filterChar);
-    voice.setModMatrix (mod1Source, mod1Dest, mod1Amount,
-                        mod2Source, mod2Dest, mod2Amount,
-                        mod3Source, mod3Dest, mod3Amount,
-                        lfo1TargetRate, lfo2TargetRate, modEnvDecay);
+void AcidSynthAudioProcessor::handleNoteOn (juce::MidiKeyboardState*, int, int midiNoteNumber, float velocity)
+{
+    if (showingHostNotes)
+        return;
 
-    // handle MIDI (mono)
-    for (const auto metadata : midi)
+    // a zero velocity would read as a note-off on the audio side
+    pushUiNote (midiNoteNumber, juce::jmax (velocity, 1.0f / 127.0f));
+}
+
+void AcidSynthAudioProcessor::handleNoteOff (juce::MidiKeyboardState*, int, int midiNoteNumber, float)
+{
+    if (showingHostNotes)
+        return;
+
+    pushUiNote (midiNoteNumber, 0.0f);
+}
+
+void AcidSynthAudioProcessor::pushUiNote (int midiNoteNumber, float velocity)
+{
+    const bool queued = uiNotes.push ({ juce::Time::getMillisecondCounterHiRes(), (int8_t) midiNoteNumber, velocity });
+    jassertquiet (queued);
+}
+
+// Drains the on-screen keyboard queue into blockUiNotes (in time order) and
+// returns how many notes this block has.
+int AcidSynthAudioProcessor::collectUiNotes (int numSamples)
+{
+    const double blockStartMs = juce::Time::getMillisecondCounterHiRes();
+    const double samplesPerMs = getSampleRate() * 0.001;
+    const int lastSample = juce::jmax (0, numSamples - 1);
+    int count = 0;
+
+    uiNotes.popAll ([&] (const UiNoteQueue::Event& event)
     {
-        const auto msg = metadata.getMessage();
-
-        if (msg.isNoteOn())
-            voice.noteOn (msg.getNoteNumber(), msg.getFloatVelocity());
-        else if (msg.isNoteOff())
-            voice.noteOff (msg.getNoteNumber());
-        else if (msg.isChannelPressure())
-            currentAftertouch = msg.getChannelPressureValue() / 127.0f;
-        else if (msg.isAftertouch())
-            currentAftertouch = msg.getAfterTouchValue() / 127.0f;
-        else if (msg.isAllNotesOff() || msg.isAllSoundOff())
-            voice.reset();
-    }
+        const auto offset = (int) ((event.timeMs - lastBlockStartMs) * samplesPerMs);
+        blockUiNotes[(size_t) count++] = { juce::jlimit (0, lastSample, offset), event.note, event.velocity };
+    });
+
+    lastBlockStartMs = blockStartMs;
+    return count;
+}
+
+void AcidSynthAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    juce::ScopedNoDenormals noDenormals;
+    buffer.clear();
 
-    voice.setAftertouch (currentAftertouch);
+    const double bpm = getHostBpm (getPlayHead());
+    if (parameterGeneration.load (std::memory_order_acquire) != appliedGeneration
+        || bpm != appliedBpm || isNonRealtime() != appliedOffline)
+        applyParameterChanges (bpm);
+
+    volumeRamp.setTargetValue (params.volume->load());
+    fxDriveRamp.setTargetValue (juce::jlimit (0.0f, 1.0f, params.fxDrive->load()));
+    fxDelayRamp.setTargetValue (juce::jlimit (0.0f, 1.0f, params.fxDelay->load()));
+    const float fxChorus = params.fxChorus->load();
+    delay.setDelayTimeMs (getDelayTimeMs (bpm));
+    delay.setPingPong (params.fxDelayPingPong->load() > 0.5f);
+    const float fxReverb = params.fxReverb->load();
+
+    const int latency = getTotalLatencySamples();
+    if (latency != getLatencySamples())
+        setLatencySamples (latency);
 
     const int numSamples = buffer.getNumSamples();
     const int numCh = buffer.getNumChannels();
+    const int numUiNotes = collectUiNotes (numSamples);
+
+    auto applyUiNote = [this] (const BlockUiNote& uiNote)
+    {
+        if (uiNote.velocity > 0.0f)
+            voice.noteOn (uiNote.note, uiNote.velocity);
+        else
+            voice.noteOff (uiNote.note);
+    };
 
     if (numCh == 0 || numSamples == 0)
+    {
+        for (int i = 0; i < numUiNotes; ++i)
+            applyUiNote (blockUiNotes[(size_t) i]);
+
+        for (const auto metadata : midi)
+            handleMidiEvent (metadata.getMessage());
+
         return;
+    }
 
-    for (int i = 0; i < numSamples; ++i)
+    // Render up to each event's timestamp before applying it, so notes, slides
+    // and accents land on their sample. Events that follow an event boundary by
+    // less than minMidiSubBlock samples are applied together at that boundary,
+    // which keeps MIDI floods from splitting the block into tiny renders.
+    constexpr int minMidiSubBlock = 8;
+    auto* left = buffer.getWritePointer (0);
+    auto* right = (numCh > 1) ? buffer.getWritePointer (1) : nullptr;
+    int rendered = 0;
+    bool atEventBoundary = false;
+    bool voiceSounded = false;
+
+    // an idle voice is silent until its next note, so its stretch of the (cleared) buffer is left alone
+    auto renderVoiceUpTo = [&] (int end)
     {
-        const auto s = voice.renderStereo();
-        if (numCh == 1)
-            buffer.setSample (0, i, 0.5f * (s[0] + s[1]));
+        if (! voice.isIdle())
+        {
+            voice.renderBlock (left + rendered, (right != nullptr) ? right + rendered : nullptr, end - rendered);
+            voiceSounded = true;
+        }
         else
         {
-            buffer.setSample (0, i, s[0]);
-            buffer.setSample (1, i, s[1]);
+            voice.skipIdle (end - rendered);
         }
-    }
 
-    const float distortionMix = juce::jlimit (0.0f, 1.0f, fxDrive);
-    if (distortionMix > 0.0001f)
+        rendered = end;
+    };
+
+    auto renderUpToEvent = [&] (int eventPos)
     {
-        const float driveAmt = 1.0f + 10.0f * distortionMix;
-        for (int ch = 0; ch < numCh; ++ch)
+        if (eventPos > rendered && (! atEventBoundary || eventPos - rendered >= minMidiSubBlock))
+            renderVoiceUpTo (eventPos);
+
+        atEventBoundary = true;
+    };
+
+    // host MIDI and on-screen keyboard notes are both in time order; merge them
+    int uiIndex = 0;
+
+    for (const auto metadata : midi)
+    {
+        const int eventPos = juce::jlimit (0, numSamples, metadata.samplePosition);
+
+        for (; uiIndex < numUiNotes && blockUiNotes[(size_t) uiIndex].samplePosition <= eventPos; ++uiIndex)
         {
-            auto* data = buffer.getWritePointer (ch);
-            for (int i = 0; i < numSamples; ++i)
-            {
-                const float dry = data[i];
-                const float wet = std::tanh (dry * driveAmt);
-                data[i] = dry + (wet - dry) * distortionMix;
-            }
+            renderUpToEvent (blockUiNotes[(size_t) uiIndex].samplePosition);
+            applyUiNote (blockUiNotes[(size_t) uiIndex]);
         }
+
+        renderUpToEvent (eventPos);
+        handleMidiEvent (metadata.getMessage());
     }
 
-    const float chorusMix = juce::jlimit (0.0f, 1.0f, fxChorus);
-    if (chorusMix > 0.0001f)
+    for (; uiIndex < numUiNotes; ++uiIndex)
+    {
+        renderUpToEvent (blockUiNotes[(size_t) uiIndex].samplePosition);
+        applyUiNote (blockUiNotes[(size_t) uiIndex]);
+    }
+
+    if (rendered < numSamples)
+        renderVoiceUpTo (numSamples);
+
+    // each FX control ramp is nullptr unless that control is moving in this block
+    const float* distortionRamp = fxDriveRamp.process (numSamples);
+    const float* delayRamp = fxDelayRamp.process (numSamples);
+    const float* volumeValues = volumeRamp.process (numSamples);
+
+    // once the voice has been idle for longer than the FX tail there is nothing left to process
+    if (voiceSounded)
+        fxTailRemaining = fxTailSamples;
+    else if (fxTailRemaining <= 0)
+        return;
+    else
+        fxTailRemaining -= numSamples;
+
+    FxBlockInputs fx;
+    fx.left = left;
+    fx.right = right;
+    fx.numSamples = numSamples;
+    fx.driveValues = distortionRamp;
+    fx.delayValues = delayRamp;
+    fx.chorusMix = juce::jlimit (0.0f, 1.0f, fxChorus);
+    fx.reverbMix = juce::jlimit (0.0f, 1.0f, fxReverb);
+
+    fxChain.process (numSamples, [this, &fx] (FxChain::Stage stage, FxSlot& slot)
     {
-        chorus.setRate (0.25f + 3.2f * chorusMix);
-        chorus.setDepth (0.25f + 0.55f * chorusMix);
-        chorus.setMix (chorusMix);
+        processFxStage (stage, slot, fx);
+    });
 
-        auto block = juce::dsp::AudioBlock<float> (buffer);
-        auto context = juce::dsp::ProcessContextReplacing<float> (block);
-        chorus.process (context);
+    // slots wake, tail and sleep on their own; a stage that has gone quiet
+    // shortens what is left of the tail from here on
+    if (fxChain.getSlotStates() != fxTailSlotStates)
+    {
+        updateFxTail();
+        fxTailRemaining = juce::jmin (fxTailRemaining, fxTailSamples);
     }
 
-    const float delayMix = juce::jlimit (0.0f, 1.0f, fxDelay);
-    if (delayMix > 0.0001f)
+    if (volumeValues != nullptr)
+    {
+        for (int ch = 0; ch < numCh; ++ch)
+            juce::FloatVectorOperations::multiply (buffer.getWritePointer (ch), volumeValues, numSamples);
+    }
+    else if (volumeRamp.getTargetValue() != 1.0f)
     {
-        const float delaySamples = (float) getSampleRate() * (fxDelayTime * 0.001f);
-        delayLineL.setDelay (delaySamples);
-        delayLineR.setDelay (delaySamples);
+        buffer.applyGain (volumeRamp.getTargetValue());
+    }
+}
 
-        const float feedback = 0.35f + 0.25f * delayMix;
-        for (int i = 0; i < numSamples; ++i)
-        {
-            const float inL = buffer.getSample (0, i);
-            const float inR = (numCh > 1) ? buffer.getSample (1, i) : inL;
+// Each stage runs through its FxSlot: a stage whose mix reaches 0 fades out
+// and keeps running until its tail has gone, then sleeps with its buffers
+// cleared. Chorus and delay fade through their own mix controls; the drive and
+// reverb fade their sends.
+void AcidSynthAudioProcessor::processFxStage (FxChain::Stage stage, FxSlot& slot, const FxBlockInputs& fx)
+{
+    constexpr float minMix = 0.0001f;
+    float* left = fx.left;
+    float* right = fx.right;
+    const int numSamples = fx.numSamples;
 
-            const float dl = delayLineL.popSample (0);
-            const float dr = delayLineR.popSample (0);
+    switch (stage)
+    {
+        case FxChain::drive:
+        {
+            // the drive also fades its send, since its resampled and ADAA tiers
+            // change the signal slightly even at a mix of 0. The resampled
+            // tiers fade to their input delayed by their latency and keep
+            // delaying it while asleep, so the reported latency always holds.
+            const float distortionMix = fxDriveRamp.getTargetValue();
+            if (slot.begin (distortionMix > minMix, left, right, numSamples))
+            {
+                drive.process (left, right, numSamples, fx.driveValues, distortionMix,
+                               slot.getSendValues(), slot.getSend());
 
-            delayLineL.pushSample (0, inL + dl * feedback);
-            delayLineR.pushSample (0, inR + dr * feedback);
+                if (slot.end())
+                    drive.reset();
+            }
+            else
+            {
+                drive.processAsleep (left, right, numSamples);
+            }
+            break;
+        }
 
-            buffer.setSample (0, i, inL + dl * delayMix);
-            if (numCh > 1)
-                buffer.setSample (1, i, inR + dr * delayMix);
+        case FxChain::chorus:
+        {
+            const float chorusMix = fx.chorusMix;
+            if (slot.begin (chorusMix > minMix, left, right, numSamples))
+            {
+                // the chorus smooths its own mix, so a mix of 0 fades it out
+                if (chorusMix > minMix)
+                {
+                    chorus.setRate (0.25f + 3.2f * chorusMix);
+                    chorus.setDepth (0.25f + 0.55f * chorusMix);
+                }
+
+                chorus.setMix (chorusMix);
+
+                float* channels[] = { left, right };
+                auto block = juce::dsp::AudioBlock<float> (channels, (right != nullptr) ? 2u : 1u, (size_t) numSamples);
+                auto context = juce::dsp::ProcessContextReplacing<float> (block);
+                chorus.process (context);
+
+                if (slot.end (left, right, numSamples))
+                    chorus.reset();
+            }
+            break;
         }
-    }
 
-    const float reverbMix = juce::jlimit (0.0f, 1.0f, fxReverb);
-    if (reverbMix > 0.0001f)
-    {
-        juce::Reverb::Parameters params;
-        params.roomSize = 0.2f + 0.7f * reverbMix;
-        params.damping = 0.45f + 0.35f * reverbMix;
-        params.wetLevel = 0.12f + 0.35f * reverbMix;
-        params.dryLevel = 1.0f - 0.2f * reverbMix;
-        params.width = 1.0f;
-        reverb.setParameters (params);
-
-        if (numCh > 1)
+        case FxChain::delay:
         {
-            reverb.processStereo (buffer.getWritePointer (0),
-                                  buffer.getWritePointer (1),
-                                  numSamples);
+            // the delay's mix is its send, so its ramp down to 0 leaves the repeats ringing
+            const float delayMix = fxDelayRamp.getTargetValue();
+            if (slot.begin (delayMix > minMix, left, right, numSamples))
+            {
+                delay.process (left, right, numSamples, fx.delayValues, delayMix);
+
+                if (slot.end (left, right, numSamples))
+                    delay.reset();
+            }
+            break;
         }
-        else
+
+        case FxChain::reverb:
         {
-            reverb.processMono (buffer.getWritePointer (0), numSamples);
+            const float reverbMix = fx.reverbMix;
+            const bool reverbWanted = reverbMix > minMix;
+            if (slot.begin (reverbWanted, left, right, numSamples))
+            {
+                // while tailing the room keeps its last settings and the dry path
+                // ramps to unity alongside the send fade, so the stage sleeps
+                // without a step in level
+                auto settings = reverb.getParameters();
+                settings.dryLevel = 0.5f;
+
+                if (reverbWanted)
+                {
+                    settings.roomSize = 0.2f + 0.7f * reverbMix;
+                    settings.damping = 0.45f + 0.35f * reverbMix;
+                    settings.wetLevel = 0.12f + 0.35f * reverbMix;
+                    settings.dryLevel = 1.0f - 0.2f * reverbMix;
+                }
+
+                reverb.setParameters (settings);
+                reverb.process (left, right, numSamples, slot.getSendValues(), slot.getSend());
+
+                if (slot.end (left, right, numSamples))
+                    reverb.reset();
+            }
+            break;
         }
-    }
 
-    if (volume != 1.0f)
-        buffer.applyGain (volume);
+        case FxChain::numStages:
+        default:
+            break;
+    }
 }
 
 bool AcidSynthAudioProcessor::hasEditor() const
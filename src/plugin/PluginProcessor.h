@@ -1,6 +1,19 @@
 #pragma once
 #include <JuceHeader.h>
+#include "CoefficientCache.h"
+#include "FdnReverb.h"
+#include "FxChain.h"
+#include "FxDrive.h"
+#include "FastMath.h"
+#include "NoteStack.h"
+#include "ParameterRamp.h"
+#include "RenderWorkerPool.h"
+#include "StereoDelay.h"
+#include "UiNoteQueue.h"
 #include <array>
+#include <atomic>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
@@ -11,26 +24,32 @@
 class AcidVoice
 {
 public:
-    void prepare (double sampleRate)
+    void prepare (double sampleRate, int maximumBlockSize)
     {
         sr = (float) sampleRate;
+        prepareBlockResources (maximumBlockSize);
+
+        for (auto* ramp : { &cutoffRamp, &resRamp, &driveRamp, &satRamp, &gainRamp })
+            ramp->prepare (sampleRate, 0.02, maxBlockSize);
+        snapControls = true;
         filterCharSmoothed.reset (sr, 0.01);
         filterCharSmoothed.setCurrentAndTargetValue (0.0f);
         accentSmoothed.reset (sr, 0.01);
         accentSmoothed.setCurrentAndTargetValue (0.0f);
 
         phase = 0.0f;
-        phaseUnisonA = 0.0f;
-        phaseUnisonB = 0.0f;
+        unisonPhase.fill (0.0f);
         phaseSub = 0.0f;
         lfo1Phase = 0.0f;
         lfo2Phase = 0.0f;
         env = 0.0f;
-        envCoef = 0.0f;
         modEnv = 0.0f;
-        modEnvCoef = 0.0f;
         releaseEnv = 0.0f;
         releaseCoef = 0.0f;
+        releaseCoefCache.reset();
+        glideCoefCache.reset();
+        envCoefCache.reset();
+        modEnvCoefCache.reset();
 
         targetFreq  = 110.0f;
         currentFreq = 110.0f;
@@ -40,13 +59,23 @@ public:
         releaseActive = false;
         accentKick = 0.0f;
         accentKickCoef = std::exp (-1.0f / (sr * 0.012f));
+        controlKickCoef = std::pow (accentKickCoef, (float) controlInterval);
+        controlCountdown = 0;
+        controlFrameValid = false;
         vel  = 0.0f;
         aftertouch = 0.0f;
         heldNotes.clear();
+        poly = {};
 
         // filter state
+        filterMono = {};
+
+       #if JUCE_USE_SIMD
+        filterStereo = {};
+       #else
         filterL = {};
         filterR = {};
+       #endif
         filterCharSmoothed.setCurrentAndTargetValue (0.0f);
 
         // legacy lp not used anymore, but keep zeroed in case you referenced it elsewhere
@@ -65,30 +94,30 @@ public:
                     int filterCharIn)
     {
         wave    = waveIn;
-        cutoff  = cutoffIn;     // Hz
-        res     = resIn;        // 0..1
         envmod  = envmodIn;     // 0..1-ish
         decay   = decayIn;      // seconds
         release = releaseIn;    // seconds
         accent  = accentIn;     // 0..1
         glideMs = glideMsIn;    // ms
-        drive   = driveIn;      // 0..1
-        sat     = satIn;        // 0..1
         subMix  = subMixIn;     // 0..1
         unison  = unisonIn;     // 0..1
         unisonSpread = unisonSpreadIn; // 0..1
-        gain    = gainIn;       // linear
+
+        // continuous controls ramp to their new values (see ParameterRamp)
+        setControl (cutoffRamp, cutoffIn);                           // Hz
+        setControl (resRamp, resIn);                                 // 0..1
+        setControl (driveRamp, driveIn);                             // 0..1
+        setControl (satRamp, juce::jlimit (0.0f, 1.0f, satIn));      // 0..1
+        setControl (gainRamp, gainIn);                               // linear
+        snapControls = false;
         targetFilterChar = juce::jlimit (0, 4, filterCharIn);
         filterCharSmoothed.setTargetValue ((float) targetFilterChar);
 
-        // simple exponential decay envelope coefficient
-        const float d = juce::jmax (0.001f, decay);
-        envCoef = std::exp (-1.0f / (sr * d));
-
+        // the decay coefficients themselves follow accent and modulation, see evaluateModulation()
         if (release <= 0.0001f)
             releaseCoef = 0.0f;
         else
-            releaseCoef = std::exp (-1.0f / (sr * release));
+            releaseCoef = releaseCoefCache.get (release, sr);
     }
 
     void setModMatrix (int src1, int dst1, float amt1,
@@ -106,9 +135,15 @@ public:
         lfo1FreqSmoothed.setTargetValue (lfo1RateIn);
         lfo2FreqSmoothed.setTargetValue (lfo2RateIn);
         modEnvDecay = modEnvDecayIn;
+    }
 
-        const float d = juce::jmax (0.01f, modEnvDecay);
-        modEnvCoef = std::exp (-1.0f / (sr * d));
+    // The first values after prepare() are applied without a ramp.
+    void setControl (ParameterRamp& ramp, float value)
+    {
+        if (snapControls)
+            ramp.setCurrentAndTargetValue (value);
+        else
+            ramp.setTargetValue (value);
     }
 
     void setAftertouch (float pressure)
@@ -119,12 +154,20 @@ public:
     void noteOn (int midiNote, float velocity)
     {
         const float clampedVelocity = juce::jlimit (0.0f, 1.0f, velocity);
+
+        if (polyMode)
+        {
+            polyNoteOn (midiNote, clampedVelocity);
+            return;
+        }
+
         const bool isAccented = (clampedVelocity > 0.7f) && (accent > 0.001f);
 
-        heldNotes.erase (std::remove_if (heldNotes.begin(), heldNotes.end(),
-                                         [midiNote] (const HeldNote& note) { return note.note == midiNote; }),
-                         heldNotes.end());
-        heldNotes.push_back ({ midiNote, clampedVelocity });
+        heldNotes.push (midiNote, clampedVelocity);
+
+        // with low/high priority a new note only takes over if it is the new lowest/highest
+        if (gate && heldNotes.getNote (notePriority) != midiNote)
+            return;
 
         const bool wasGate = gate;
         gate = true;
@@ -138,8 +181,7 @@ public:
         {
             currentFreq = targetFreq;
             phase = 0.0f;
-            phaseUnisonA = 0.0f;
-            phaseUnisonB = 0.0f;
+            unisonPhase.fill (0.0f);
             phaseSub = 0.0f;
             env = 1.0f; // instant attack for now
             modEnv = 1.0f;
@@ -153,18 +195,22 @@ public:
 
     void noteOff (int midiNote)
     {
-        heldNotes.erase (std::remove_if (heldNotes.begin(), heldNotes.end(),
-                                         [midiNote] (const HeldNote& note) { return note.note == midiNote; }),
-                         heldNotes.end());
+        if (polyMode)
+        {
+            polyNoteOff (midiNote);
+            return;
+        }
+
+        heldNotes.remove (midiNote);
 
         if (midiNote == activeNote)
         {
-            if (! heldNotes.empty())
+            if (! heldNotes.isEmpty())
             {
-                const auto& next = heldNotes.back();
-                activeNote = next.note;
-                targetFreq = juce::MidiMessage::getMidiNoteInHertz (next.note);
-                vel = next.velocity;
+                const int next = heldNotes.getNote (notePriority);
+                activeNote = next;
+                targetFreq = juce::MidiMessage::getMidiNoteInHertz (next);
+                vel = heldNotes.getVelocity (next);
                 gate = true;
                 glideActive = true;
             }
@@ -193,262 +239,234 @@ public:
         activeNote = -1;
         heldNotes.clear();
         accentKick = 0.0f;
+        poly = {};
 
         phase = 0.0f;
-        phaseUnisonA = 0.0f;
-        phaseUnisonB = 0.0f;
+        unisonPhase.fill (0.0f);
         phaseSub = 0.0f;
 
+        filterMono = {};
+
+       #if JUCE_USE_SIMD
+        filterStereo = {};
+       #else
         filterL = {};
         filterR = {};
+       #endif
         filterCharSmoothed.setCurrentAndTargetValue ((float) targetFilterChar);
-    }
-
-    std::array<float, 2> renderStereo()
-    {
-        // --- glide (as in your original code) ---
-        const float glideSec  = juce::jmax (0.0f, glideMs) * 0.001f;
-        const float glideCoef = (glideSec <= 0.0f) ? 0.0f : std::exp (-1.0f / (sr * glideSec));
-        if (glideActive)
-            currentFreq = glideCoef * currentFreq + (1.0f - glideCoef) * targetFreq;
-        else
-            currentFreq = targetFreq;
 
-        // --- modulation sources ---
-        const float lfo1RateStep = lfo1FreqSmoothed.getNextValue();
-        const float lfo2RateStep = lfo2FreqSmoothed.getNextValue();
-        lfo1Phase += lfo1RateStep / sr;
-        lfo2Phase += lfo2RateStep / sr;
-        if (lfo1Phase >= 1.0f) lfo1Phase -= 1.0f;
-        if (lfo2Phase >= 1.0f) lfo2Phase -= 1.0f;
-
-        const float lfo1 = std::sin (juce::MathConstants<float>::twoPi * lfo1Phase);
-        const float lfo2 = std::sin (juce::MathConstants<float>::twoPi * (lfo2Phase + 0.25f));
-
-        // --- Accent macro (velocity + Accent parameter) ---
-        // Accent shapes multiple targets like a classic 303: cutoff/res/envmod/drive/decay.
-        const float accentGate = (vel > 0.7f) ? 1.0f : 0.0f;
-        const float accentTarget = juce::jlimit (0.0f, 1.0f, accent * accentGate);
-        accentSmoothed.setTargetValue (accentTarget);
-        const float accentBase = accentSmoothed.getNextValue();
-        const float accentShaped = std::pow (accentBase, 2.2f);
+        controlCountdown = 0;
+        controlFrameValid = false;
 
-        const float accentKickValue = accentKick;
-        accentKick *= accentKickCoef;
-        if (accentKick < 1.0e-5f)
-            accentKick = 0.0f;
+        for (auto& os : oversamplers)
+            if (os != nullptr)
+                os->reset();
 
-        const float accentTotal = juce::jlimit (0.0f, 1.0f, accentShaped + 0.35f * accentKickValue);
+        std::fill (scratchScale.begin(), scratchScale.end(), 0.0f);
+    }
 
-        // --- envelope decay (accent slightly tightens decay times) ---
-        const float decayScaled = juce::jmax (0.01f, decay * (1.0f - 0.25f * accentTotal));
-        const float modDecayScaled = juce::jmax (0.01f, modEnvDecay * (1.0f - 0.15f * accentTotal));
-        const float envCoefLocal = std::exp (-1.0f / (sr * decayScaled));
-        const float modEnvCoefLocal = std::exp (-1.0f / (sr * modDecayScaled));
-        env *= envCoefLocal;
-        modEnv *= modEnvCoefLocal;
+    // Single sample at the base rate (never oversampled).
+    std::array<float, 2> renderStereo()
+    {
+        const auto constants = beginBlock (1);
+        return renderSample (constants);
+    }
 
-        if (gate)
-        {
-            releaseEnv = 1.0f;
-            releaseActive = false;
-        }
-        else if (releaseActive)
+    // Renders numSamples straight into the output channel pointers.
+    // Everything that cannot change inside a block is computed once up front.
+    // Pass right == nullptr for a mono bus: left then receives the L/R average.
+    void renderBlock (float* left, float* right, int numSamples)
+    {
+        // the control ramps and the scratch buffers of the staged paths hold maxBlockSize samples
+        for (int start = 0; start < numSamples; start += maxBlockSize)
         {
-            if (releaseCoef <= 0.0f)
+            const int n = juce::jmin (maxBlockSize, numSamples - start);
+            float* l = left + start;
+            float* r = (right != nullptr) ? right + start : nullptr;
+            const auto constants = beginBlock (n);
+
+            if (polyMode)
             {
-                releaseEnv = 0.0f;
+                renderPoly (constants, l, r, n);
+            }
+            else if (activeOversampler != nullptr)
+            {
+                renderOversampled (constants, l, r, n);
             }
             else
             {
-                releaseEnv *= releaseCoef;
-                if (releaseEnv < 1.0e-4f)
-                    releaseEnv = 0.0f;
+                runModulation (n, [&] (int i, const ModFrame& mod)
+                {
+                    writeOutput (l, r, i, renderVoice (constants, mod, i));
+                });
             }
 
-            if (releaseEnv == 0.0f)
-                releaseActive = false;
-        }
-
-        float modCutoff = 0.0f;
-        float modPitch = 0.0f;
-        float modDrive = 0.0f;
-        float modGain = 0.0f;
-        float modPan = 0.0f;
-        float modRes = 0.0f;
-
-        for (const auto& slot : slots)
-        {
-            const float source = getSourceValue (slot.source, lfo1, lfo2);
-            const float amount = slot.amount;
+            flushEnvelopes();
 
-            switch (slot.dest)
+            // a ladder that went non-finite stays that way, so checking once per block catches it
+            if (! sanitiseFilterStates())
             {
-                case 1: // Cutoff
-                    modCutoff += source * amount * 6000.0f;
-                    break;
-                case 2: // Pitch
-                    modPitch += source * amount * 12.0f;
-                    break;
-                case 3: // Drive
-                    modDrive += source * amount * 0.45f;
-                    break;
-                case 4: // Gain
-                    modGain += source * amount * 0.5f;
-                    break;
-                case 5: // Pan
-                    modPan += source * amount;
-                    break;
-                case 6: // Resonance
-                    modRes += source * amount * 0.35f;
-                    break;
-                default:
-                    break;
+                juce::FloatVectorOperations::clear (l, n);
+                if (r != nullptr)
+                    juce::FloatVectorOperations::clear (r, n);
             }
         }
+    }
 
-        const float pitchRatio = std::pow (2.0f, modPitch / 12.0f);
-        const float modulatedFreq = currentFreq * pitchRatio;
-
-        // --- oscillator: saw -> square morph (same idea as before) ---
-        phase += modulatedFreq / sr;
-        if (phase >= 1.0f) phase -= 1.0f;
+    // Samples between modulation updates in renderBlock(); 1 evaluates the
+    // mod matrix, LFOs and accent every sample (the original behaviour).
+    void setControlRate (int intervalSamples)
+    {
+        const int interval = juce::jlimit (1, 64, intervalSamples);
+        if (interval == controlInterval)
+            return;
+
+        controlInterval = interval;
+        controlKickCoef = std::pow (accentKickCoef, (float) controlInterval);
+        controlCountdown = 0;
+        controlFrameValid = false;
+    }
 
-        auto renderWave = [this] (float p)
-        {
-            float saw = 2.0f * p - 1.0f;
-            float sq  = (p < 0.5f) ? 1.0f : -1.0f;
-            return juce::jmap (wave, saw, sq);
-        };
+    // Oversampling factor for the nonlinear section (drive, ladder, tanh and
+    // saturation) as a power of two: 0 = off, 1 = 2x, 2 = 4x, 3 = 8x.
+    // The resamplers are built in prepare(), so switching never allocates.
+    void setOversampling (int factorLog2)
+    {
+        const int index = juce::jlimit (0, maxOversamplingLog2, factorLog2);
+        if (index == oversamplingLog2)
+            return;
 
-        float oscMain = renderWave (phase);
+        oversamplingLog2 = index;
+        activeOversampler = (index == 0) ? nullptr : oversamplers[(size_t) index - 1].get();
 
-        const float unisonAmt = juce::jlimit (0.0f, 1.0f, unison);
-        float oscA = 0.0f;
-        float oscB = 0.0f;
+        if (activeOversampler != nullptr)
+            activeOversampler->reset();
 
-        if (unisonAmt > 0.0001f)
-        {
-            const float detuneCents = 7.0f + 25.0f * unisonAmt;
-            const float detuneRatio = std::pow (2.0f, detuneCents / 1200.0f);
+        std::fill (scratchScale.begin(), scratchScale.end(), 0.0f);
+    }
 
-            phaseUnisonA += (modulatedFreq * detuneRatio) / sr;
-            phaseUnisonB += (modulatedFreq / detuneRatio) / sr;
+    // Delay added by the active resampler pair, in base-rate samples. Poly
+    // voices are never resampled, so they add none.
+    int getLatencySamples() const
+    {
+        if (polyMode || activeOversampler == nullptr)
+            return 0;
 
-            if (phaseUnisonA >= 1.0f) phaseUnisonA -= 1.0f;
-            if (phaseUnisonB >= 1.0f) phaseUnisonB -= 1.0f;
+        return (int) std::round (activeOversampler->getLatencyInSamples());
+    }
 
-            oscA = renderWave (phaseUnisonA);
-            oscB = renderWave (phaseUnisonB);
-        }
+    static constexpr int maxOversamplingLog2 = 3;
 
-        const float subAmt = juce::jlimit (0.0f, 1.0f, subMix);
-        if (subAmt > 0.0001f)
+    // True once the voice can only output silence until the next note: every
+    // amplitude envelope is below -80 dB. The ladder output is scaled by them,
+    // so whatever is left in the filter state cannot be heard. Callers may skip
+    // renderBlock() while this holds.
+    bool isIdle() const
+    {
+        if (polyMode)
         {
-            phaseSub += (modulatedFreq * 0.5f) / sr;
-            if (phaseSub >= 1.0f) phaseSub -= 1.0f;
-        }
-
-        // --- cutoff with envelope modulation (accent opens cutoff and boosts env depth) ---
-        // envmod maps to an added cutoff range.
-        const float cutoffAccent = cutoff * (1.0f + 1.2f * accentTotal);
-        const float envmodAccent = envmod * (1.0f + 0.6f * accentTotal);
-        float fc = cutoffAccent + envmodAccent * 5000.0f * env + modCutoff;
-        fc = juce::jlimit (20.0f, 16000.0f, fc);
-
-        // --- Ladder-ish resonant 4-pole filter ---
-        // Coefficient for one-pole stage: g = 1 - exp(-2*pi*fc/sr)
-        const float g = 1.0f - std::exp (-2.0f * juce::MathConstants<float>::pi * fc / sr);
-        const float gOs = 1.0f - std::exp (-2.0f * juce::MathConstants<float>::pi * fc / (sr * 2.0f));
-
-        // Resonance amount. This is "by ear" scaling.
-        // Make sure the full knob range is audibly effective.
-        // Too high without clipping can explode, so we soft-clip the loop.
-        const float resAccented = juce::jlimit (0.0f, 0.995f, res + modRes + 0.08f * accentTotal);
-        const float resNorm = juce::jlimit (0.0f, 1.0f, resAccented);
-        const float resCurve = std::pow (resNorm, 1.35f);
-        float kBase = juce::jmap (resCurve, 0.0f, 1.0f, 0.0f, 4.8f);
-
-        // Drive: pre-gain into the ladder core
-        const float driveAccent = drive * (1.0f + 1.0f * accentTotal);
-        float driveAmt = juce::jlimit (0.0f, 1.0f, driveAccent + modDrive);
-        float pre = 1.0f + 6.0f * driveAmt;
+            for (size_t v = 0; v < (size_t) polyVoiceCount; ++v)
+                if (poly.env[v] * poly.releaseEnv[v] >= idleThreshold)
+                    return false;
 
-        float oscLeft = 0.0f;
-        float oscRight = 0.0f;
+            return true;
+        }
 
-        const float basePan = juce::jlimit (-1.0f, 1.0f, modPan);
-        const float spread = juce::jlimit (0.0f, 1.0f, unisonSpread) * (0.35f + 0.65f * unisonAmt);
+        return env * releaseEnv < idleThreshold;
+    }
 
-        const float mainWeight = 1.0f - 0.35f * unisonAmt;
-        const float sideWeight = 0.175f * unisonAmt;
+    // Stands in for renderBlock() while isIdle() holds, in O(1): the LFOs
+    // move on by numSamples so the next note meets them where it would have,
+    // and every smoother and control ramp lands on its target. The control
+    // frame is rebuilt at the next render.
+    void skipIdle (int numSamples)
+    {
+        const float lfo1RateBefore = lfo1FreqSmoothed.getCurrentValue();
+        const float lfo2RateBefore = lfo2FreqSmoothed.getCurrentValue();
+        const float lfo1RateAfter = lfo1FreqSmoothed.skip (numSamples);
+        const float lfo2RateAfter = lfo2FreqSmoothed.skip (numSamples);
 
-        addPanned (oscLeft, oscRight, oscMain * mainWeight, basePan);
+        // a smoother ramps linearly, so the mean rate over the skip is the midpoint
+        lfo1Phase += 0.5f * (lfo1RateBefore + lfo1RateAfter) * (float) numSamples / sr;
+        lfo2Phase += 0.5f * (lfo2RateBefore + lfo2RateAfter) * (float) numSamples / sr;
+        lfo1Phase -= std::floor (lfo1Phase);
+        lfo2Phase -= std::floor (lfo2Phase);
 
-        if (unisonAmt > 0.0001f)
-        {
-            addPanned (oscLeft, oscRight, oscA * sideWeight, basePan - spread);
-            addPanned (oscLeft, oscRight, oscB * sideWeight, basePan + spread);
-        }
+        for (auto* ramp : { &cutoffRamp, &resRamp, &driveRamp, &satRamp, &gainRamp })
+            ramp->setCurrentAndTargetValue (ramp->getTargetValue());
 
-        if (subAmt > 0.0001f)
-        {
-            const float sub = std::sin (juce::MathConstants<float>::twoPi * phaseSub);
-            addPanned (oscLeft, oscRight, subAmt * 0.8f * sub, basePan);
-        }
+        for (auto* smoothed : { &filterCharSmoothed, &accentSmoothed })
+            smoothed->setCurrentAndTargetValue (smoothed->getTargetValue());
 
-        const float charIndex = filterCharSmoothed.getNextValue();
-        const int idx0 = juce::jlimit (0, 4, (int) std::floor (charIndex));
-        const int idx1 = juce::jlimit (0, 4, idx0 + 1);
-        const float charMix = juce::jlimit (0.0f, 1.0f, charIndex - (float) idx0);
+        accentKick = 0.0f;
+        controlCountdown = 0;
+        controlFrameValid = false;
+        unisonPanValid = false;
+    }
 
-        const auto modeA = getFilterModeSettings (idx0);
-        const auto modeB = getFilterModeSettings (idx1);
+    // Seconds the voice keeps sounding after its last note is released.
+    float getReleaseTailSeconds() const
+    {
+        return (release <= 0.0001f) ? 0.0f : release * std::log (1.0f / idleThreshold);
+    }
 
-        auto lerp = [] (float a, float b, float t)
-        {
-            return a + (b - a) * t;
-        };
+    static constexpr float idleThreshold = 1.0e-4f;
 
-        FilterModeSettings mode {};
-        mode.kScale = lerp (modeA.kScale, modeB.kScale, charMix);
-        mode.kGScale = lerp (modeA.kGScale, modeB.kGScale, charMix);
-        mode.feedbackDrive = lerp (modeA.feedbackDrive, modeB.feedbackDrive, charMix);
-        mode.stageClip = lerp (modeA.stageClip, modeB.stageClip, charMix);
-        mode.asym = lerp (modeA.asym, modeB.asym, charMix);
-        mode.resComp = lerp (modeA.resComp, modeB.resComp, charMix);
-        mode.oversample = modeA.oversample || modeB.oversample;
-        mode.clampStages = modeA.clampStages || modeB.clampStages;
+    // Mono: one voice with glide, legato and accent kicks (the original behaviour).
+    // Poly: up to numVoices notes from a fixed pool, each with its own oscillator,
+    // sub, envelopes and ladder; modulation, unison-free. Changing either setting
+    // silences the voice.
+    void setVoiceMode (bool poly, int numVoices)
+    {
+        const int count = juce::jlimit (1, maxPolyVoices, numVoices);
+        if (poly == polyMode && count == polyVoiceCount)
+            return;
 
-        float left = processFilter (oscLeft * pre, kBase, g, gOs, mode, filterL);
-        float right = processFilter (oscRight * pre, kBase, g, gOs, mode, filterR);
+        polyMode = poly;
+        polyVoiceCount = count;
+        reset();
+    }
 
-        // optional output saturation (kept from your original "drive coloration")
-        left = std::tanh (left);
-        right = std::tanh (right);
+    static constexpr int maxPolyVoices = 32;
 
-        // post-filter drive stage for extra power
-        const float satAmt = juce::jlimit (0.0f, 1.0f, sat);
-        if (satAmt > 0.0001f)
-        {
-            left = softClip (left * (1.0f + 8.0f * satAmt));
-            right = softClip (right * (1.0f + 8.0f * satAmt));
-        }
+    // Oscillators stacked on a mono note, the main one included (1 = no
+    // unison). They are detuned and panned in symmetric pairs by the unison
+    // amount and spread: an odd count keeps the main oscillator at the centre,
+    // an even count pairs it off too, so nothing sits at the centre. Poly
+    // voices never use unison.
+    void setUnisonVoices (int numVoices)
+    {
+        unisonVoices = juce::jlimit (1, maxUnisonVoices, numVoices);
+    }
 
-        // modest accent gain bump (the main accent impact is tone/drive/decay)
-        const float acc = 1.0f + 0.2f * accentTotal;
+    static constexpr int maxUnisonVoices = 16;
 
-        float outGain = juce::jlimit (0.0f, 2.0f, gain + modGain);
+    // Which held note a mono voice plays: 0 = last pressed, 1 = lowest,
+    // 2 = highest. Releasing the sounding note glides back to the next one
+    // by the same rule.
+    void setNotePriority (int priority)
+    {
+        notePriority = (HeldNoteStack::Priority) juce::jlimit (0, 2, priority);
+    }
 
-        const float ampEnv = env * releaseEnv;
-        left *= ampEnv * acc * outGain;
-        right *= ampEnv * acc * outGain;
+    // Pan law for the oscillators, unison spread and pan modulation:
+    // 0 = -3 dB, 1 = -4.5 dB, 2 = -6 dB at the centre.
+    void setPanLaw (int law)
+    {
+        const int newLaw = juce::jlimit (0, CoefficientTables::numPanLaws - 1, law);
+        if (newLaw == panLaw)
+            return;
 
-        // avoid denormals
-        if (std::abs (left) < 1e-12f) left = 0.0f;
-        if (std::abs (right) < 1e-12f) right = 0.0f;
+        panLaw = newLaw;
+        unisonLayout.lastCount = -1;  // its static pans follow the law
+        unisonPanValid = false;
+    }
 
-        return { left, right };
+    // Lets renderPoly() spread its voice groups over the pool's threads;
+    // nullptr (the default) renders everything on the calling thread.
+    void setRenderWorkers (RenderWorkerPool* pool)
+    {
+        renderWorkers = pool;
     }
 
 private:
@@ -458,12 +476,45 @@ private:
         return v / (1.0f + a * std::abs (v));
     }
 
+    // v * (1 + asym) for v >= 0 and v * (1 - asym) below, written branch-free
     static inline float softClipAsym (float v, float a, float asym)
     {
-        const float drive = v * ((v >= 0.0f) ? (1.0f + asym) : (1.0f - asym));
+        const float drive = v + asym * std::abs (v);
         return softClip (drive, a);
     }
 
+    // Two-sample polynomial residual of a unit step at phase 0; t is the phase and
+    // dt the phase increment, both in cycles.
+    static inline float polyBlep (float t, float dt)
+    {
+        if (t < dt)
+        {
+            t /= dt;
+            return t + t - t * t - 1.0f;
+        }
+
+        if (t > 1.0f - dt)
+        {
+            t = (t - 1.0f) / dt;
+            return t * t + t + t + 1.0f;
+        }
+
+        return 0.0f;
+    }
+
+    // Saw -> square morph with PolyBLEP-corrected edges. The correction is linear
+    // in each edge, so blending the corrected shapes keeps the original morph.
+    static inline float renderWave (float p, float dt, float morph)
+    {
+        const float saw = 2.0f * p - 1.0f - polyBlep (p, dt);
+
+        float pHalf = p + 0.5f;
+        if (pHalf >= 1.0f) pHalf -= 1.0f;
+        const float sq = ((p < 0.5f) ? 1.0f : -1.0f) + polyBlep (p, dt) - polyBlep (pHalf, dt);
+
+        return juce::jmap (morph, saw, sq);
+    }
+
     struct FilterState
     {
         float z1 = 0.0f;
@@ -480,33 +531,36 @@ private:
         float amount = 0.0f;
     };
 
-    struct HeldNote
-    {
-        int note = -1;
-        float velocity = 0.0f;
-    };
-
-    float getSourceValue (int sourceId, float lfo1, float lfo2) const
+    float getSourceValue (int sourceId, float lfo1, float lfo2, float modEnvValue) const
     {
         switch (sourceId)
         {
             case 1: return lfo1;
             case 2: return lfo2;
-            case 3: return modEnv;
+            case 3: return modEnvValue;
             case 4: return vel;
             case 5: return aftertouch;
             default: return 0.0f;
         }
     }
 
-    static inline void addPanned (float& left, float& right, float value, float pan)
+    struct PanGains
+    {
+        float left = 0.0f;
+        float right = 0.0f;
+    };
+
+    // Gains for a pan position (clamped to -1..1) under the current pan law.
+    PanGains getPanGains (float pan) const
+    {
+        const auto& panLeft = CoefficientTables::get().panLeft[(size_t) panLaw];
+        return { panLeft (pan), panLeft (-pan) };
+    }
+
+    static inline void addPanned (float& left, float& right, float value, const PanGains& gains)
     {
-        const float clamped = juce::jlimit (-1.0f, 1.0f, pan);
-        const float angle = (clamped + 1.0f) * 0.25f * juce::MathConstants<float>::pi;
-        const float gL = std::cos (angle);
-        const float gR = std::sin (angle);
-        left += value * gL;
-        right += value * gR;
+        left += value * gains.left;
+        right += value * gains.right;
     }
 
     struct FilterModeSettings
@@ -523,67 +577,27 @@ private:
         bool clampStages = false;
     };
 
-    static inline FilterModeSettings getFilterModeSettings (int mode)
-    {
-        FilterModeSettings settings {};
-        switch (mode)
-        {
-            case 1: // Clean Ladder
-                settings.kScale = 0.95f;
-                settings.kGScale = 0.35f;
-                settings.feedbackDrive = 0.6f;
-                settings.stageClip = 0.4f;
-                settings.resComp = 0.22f;
-                settings.inputDrive = 0.85f;
-                settings.outputGain = 1.02f;
-                break;
-            case 2: // Aggressive
-                settings.kScale = 1.1f;
-                settings.kGScale = 0.2f;
-                settings.feedbackDrive = 1.1f;
-                settings.stageClip = 0.9f;
-                settings.asym = 0.18f;
-                settings.resComp = 0.12f;
-                settings.inputDrive = 1.1f;
-                settings.outputGain = 0.98f;
-                break;
-            case 3: // Modern
-                settings.kScale = 1.02f;
-                settings.kGScale = 0.25f;
-                settings.feedbackDrive = 0.85f;
-                settings.stageClip = 0.55f;
-                settings.resComp = 0.2f;
-                settings.inputDrive = 1.0f;
-                settings.oversample = true;
-                break;
-            case 4: // Screech
-                settings.kScale = 1.2f;
-                settings.kGScale = 0.18f;
-                settings.feedbackDrive = 1.6f;
-                settings.stageClip = 1.1f;
-                settings.asym = 0.32f;
-                settings.resComp = 0.08f;
-                settings.inputDrive = 1.2f;
-                settings.outputGain = 0.95f;
-                settings.clampStages = true;
-                break;
-            case 0: // Classic 303
-            default:
-                settings.kScale = 1.0f;
-                settings.kGScale = 0.35f;
-                settings.feedbackDrive = 0.85f;
-                settings.stageClip = 0.7f;
-                settings.resComp = 0.22f;
-                settings.inputDrive = 1.0f;
-                settings.outputGain = 0.98f;
-                settings.oversample = true;
-                break;
-        }
-        return settings;
-    }
-
-    static inline float processFilter (float input, float kBase, float g, float gOs,
-                                       const FilterModeSettings& mode, FilterState& state)
+    // Character presets, indexed by the filterChar parameter.
+    static constexpr std::array<FilterModeSettings, 5> filterModes
+    {{
+        //  kScale  kGScale  fbDrive  stageClip  asym   resComp  inDrive  outGain  oversample  clampStages
+        {   1.0f,   0.35f,   0.85f,   0.7f,      0.0f,  0.22f,   1.0f,    0.98f,   true,       false },  // Classic 303
+        {   0.95f,  0.35f,   0.6f,    0.4f,      0.0f,  0.22f,   0.85f,   1.02f,   false,      false },  // Clean Ladder
+        {   1.1f,   0.2f,    1.1f,    0.9f,      0.18f, 0.12f,   1.1f,    0.98f,   false,      false },  // Aggressive
+        {   1.02f,  0.25f,   0.85f,   0.55f,     0.0f,  0.2f,    1.0f,    1.0f,    true,       false },  // Modern
+        {   1.2f,   0.18f,   1.6f,    1.1f,      0.32f, 0.08f,   1.2f,    0.95f,   false,      true  },  // Screech
+    }};
+
+    static inline const FilterModeSettings& getFilterModeSettings (int mode)
+    {
+        return filterModes[(size_t) juce::jlimit (0, (int) filterModes.size() - 1, mode)];
+    }
+
+    // The ladder is specialised over the mode switches that would otherwise be
+    // branched on every sample; getFilterKernels() picks the instance.
+    template <bool Oversample, bool ClampStages, bool Asym, bool ResComp>
+    static float processFilterKernel (float input, float kBase, float g, float gOs,
+                                      const FilterModeSettings& mode, FilterState& state)
     {
         float k = kBase * mode.kScale;
         k *= (1.0f - mode.kGScale * g);
@@ -591,12 +605,16 @@ private:
         k = juce::jlimit (0.0f, 4.9f, k);
 
         const float inputSample = softClip (input * mode.inputDrive, 0.6f);
-        auto processSample = [&](float inSample, float gSample)
+        const float gSample = Oversample ? gOs : g;
+        const float comp = mode.resComp * (1.0f - g);
+
+        float y = 0.0f;
+        for (int step = 0; step < (Oversample ? 2 : 1); ++step)
         {
-            float u = inSample;
+            float u = inputSample;
             u -= k * state.lastY;
 
-            if (mode.asym > 0.001f)
+            if constexpr (Asym)
                 u = softClipAsym (u * mode.feedbackDrive, mode.stageClip, mode.asym);
             else
                 u = softClip (u * mode.feedbackDrive, mode.stageClip);
@@ -606,110 +624,1490 @@ private:
             state.z3 += gSample * (state.z2 - state.z3);
             state.z4 += gSample * (state.z3 - state.z4);
 
-            if (mode.clampStages)
+            if constexpr (ClampStages)
             {
                 state.z1 = juce::jlimit (-3.0f, 3.0f, state.z1);
                 state.z2 = juce::jlimit (-3.0f, 3.0f, state.z2);
                 state.z3 = juce::jlimit (-3.0f, 3.0f, state.z3);
                 state.z4 = juce::jlimit (-3.0f, 3.0f, state.z4);
             }
-            else
-            {
-                if (std::abs (state.z1) < 1e-12f) state.z1 = 0.0f;
-                if (std::abs (state.z2) < 1e-12f) state.z2 = 0.0f;
-                if (std::abs (state.z3) < 1e-12f) state.z3 = 0.0f;
-                if (std::abs (state.z4) < 1e-12f) state.z4 = 0.0f;
-            }
 
-            float y = state.z4;
-            if (mode.resComp > 0.0f)
-                y += (mode.resComp * (1.0f - g)) * (inSample - y);
-
-            if (! std::isfinite (y))
-            {
-                state = {};
-                return 0.0f;
-            }
+            y = state.z4;
+            if constexpr (ResComp)
+                y += comp * (inputSample - y);
 
             state.lastY = y;
-            return y;
-        };
+        }
 
-        float y = 0.0f;
-        if (mode.oversample)
+        return y * mode.outputGain;
+    }
+
+   #if JUCE_USE_SIMD
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    // One ladder per SIMD lane: left and right in lanes 0 and 1 for the stereo
+    // path, or one voice per lane in poly mode.
+    struct FilterLanes
+    {
+        SIMDFloat z1 = SIMDFloat::expand (0.0f);
+        SIMDFloat z2 = SIMDFloat::expand (0.0f);
+        SIMDFloat z3 = SIMDFloat::expand (0.0f);
+        SIMDFloat z4 = SIMDFloat::expand (0.0f);
+        SIMDFloat lastY = SIMDFloat::expand (0.0f);
+
+        FilterState getLane (size_t lane) const
         {
-            y = processSample (inputSample, gOs);
-            y = processSample (inputSample, gOs);
+            return { z1.get (lane), z2.get (lane), z3.get (lane), z4.get (lane), lastY.get (lane) };
         }
-        else
+
+        void setLane (size_t lane, const FilterState& s)
         {
-            y = processSample (inputSample, g);
+            z1.set (lane, s.z1);
+            z2.set (lane, s.z2);
+            z3.set (lane, s.z3);
+            z4.set (lane, s.z4);
+            lastY.set (lane, s.lastY);
         }
+    };
 
-        if (std::abs (y) < 1e-12f)
-            y = 0.0f;
-        return y * mode.outputGain;
+    static inline SIMDFloat softClip (SIMDFloat v, float a)
+    {
+        return FastMath::divide (v, FastMath::abs (v) * a + 1.0f);
     }
 
-    // --- common voice state ---
-    float sr = 44100.0f;
-
-    float phase = 0.0f;
-    float phaseUnisonA = 0.0f;
-    float phaseUnisonB = 0.0f;
-    float phaseSub = 0.0f;
-    float lfo1Phase = 0.0f;
-    float lfo2Phase = 0.0f;
+    // Same ladder as processFilterKernel(), one independent ladder per lane.
+    template <bool Oversample, bool ClampStages, bool Asym, bool ResComp>
+    static SIMDFloat processFilterLanesKernel (SIMDFloat input, SIMDFloat kBase, SIMDFloat g, SIMDFloat gOs,
+                                              const FilterModeSettings& mode, FilterLanes& state)
+    {
+        SIMDFloat k = kBase * mode.kScale;
+        k *= (SIMDFloat::expand (1.0f) - g * mode.kGScale);
 
-    float env = 0.0f;
-    float envCoef = 0.0f;
-    float modEnv = 0.0f;
-    float modEnvCoef = 0.0f;
-    float releaseEnv = 0.0f;
-    float releaseCoef = 0.0f;
+        k = FastMath::clamp (k, 0.0f, 4.9f);
 
-    float targetFreq  = 110.0f;
-    float currentFreq = 110.0f;
+        const SIMDFloat inputSample = softClip (input * mode.inputDrive, 0.6f);
+        const SIMDFloat clampLo = SIMDFloat::expand (-3.0f);
+        const SIMDFloat clampHi = SIMDFloat::expand (3.0f);
+        const SIMDFloat gSample = Oversample ? gOs : g;
+        const SIMDFloat comp = (SIMDFloat::expand (1.0f) - g) * mode.resComp;
 
-    int activeNote = -1;
-    bool  gate = false;
-    bool glideActive = false;
-    bool releaseActive = false;
-    float vel  = 0.0f;
-    float aftertouch = 0.0f;
-    std::vector<HeldNote> heldNotes;
-    float accentKick = 0.0f;
-    float accentKickCoef = 0.0f;
+        SIMDFloat y;
+        for (int step = 0; step < (Oversample ? 2 : 1); ++step)
+        {
+            SIMDFloat u = inputSample - state.lastY * k;
+            u = u * mode.feedbackDrive;
 
-    // --- params (set via setParams) ---
-    float wave    = 0.0f;     // 0..1
-    float cutoff  = 800.0f;   // Hz
-    float res     = 0.0f;     // 0..1
-    float envmod  = 0.5f;     // 0..1-ish
-    float decay   = 0.2f;     // seconds
-    float release = 0.15f;    // seconds
-    float accent  = 0.0f;     // 0..1
-    float glideMs = 0.0f;     // ms
-    float drive   = 0.0f;     // 0..1
-    float sat     = 0.0f;     // 0..1
-    float subMix  = 0.0f;     // 0..1
-    float unison  = 0.0f;     // 0..1
-    float unisonSpread = 0.0f; // 0..1
-    float gain    = 0.2f;     // linear
-    int targetFilterChar = 0;
-    juce::SmoothedValue<float> filterCharSmoothed;
-    juce::SmoothedValue<float> accentSmoothed;
+            if constexpr (Asym)
+                u = u + FastMath::abs (u) * mode.asym;
 
-    float lfo1Rate = 0.5f;
-    float lfo2Rate = 1.25f;
-    float modEnvDecay = 0.3f;
-    std::array<ModSlot, 3> slots {};
-    juce::SmoothedValue<float> lfo1FreqSmoothed;
-    juce::SmoothedValue<float> lfo2FreqSmoothed;
+            u = softClip (u, mode.stageClip);
 
-    // --- filter state (ladder-ish) ---
-    FilterState filterL;
-    FilterState filterR;
+            state.z1 += (u - state.z1) * gSample;
+            state.z2 += (state.z1 - state.z2) * gSample;
+            state.z3 += (state.z2 - state.z3) * gSample;
+            state.z4 += (state.z3 - state.z4) * gSample;
+
+            if constexpr (ClampStages)
+            {
+                state.z1 = SIMDFloat::min (SIMDFloat::max (state.z1, clampLo), clampHi);
+                state.z2 = SIMDFloat::min (SIMDFloat::max (state.z2, clampLo), clampHi);
+                state.z3 = SIMDFloat::min (SIMDFloat::max (state.z3, clampLo), clampHi);
+                state.z4 = SIMDFloat::min (SIMDFloat::max (state.z4, clampLo), clampHi);
+            }
+
+            y = state.z4;
+            if constexpr (ResComp)
+                y += (inputSample - y) * comp;
+
+            state.lastY = y;
+        }
+
+        return y * mode.outputGain;
+    }
+
+    // Both channels at once in lanes 0 and 1.
+    template <bool Oversample, bool ClampStages, bool Asym, bool ResComp>
+    static std::array<float, 2> processFilterStereoKernel (float inputL, float inputR, float kBase, float g, float gOs,
+                                                           const FilterModeSettings& mode, FilterLanes& state)
+    {
+        SIMDFloat input = SIMDFloat::expand (0.0f);
+        input.set (0, inputL);
+        input.set (1, inputR);
+
+        const auto y = processFilterLanesKernel<Oversample, ClampStages, Asym, ResComp> (input, SIMDFloat::expand (kBase),
+                                                                                          SIMDFloat::expand (g),
+                                                                                          SIMDFloat::expand (gOs),
+                                                                                          mode, state);
+        return { y.get (0), y.get (1) };
+    }
+   #endif
+
+    using MonoFilterFn = float (*) (float, float, float, float, const FilterModeSettings&, FilterState&);
+   #if JUCE_USE_SIMD
+    using StereoFilterFn = std::array<float, 2> (*) (float, float, float, float, float,
+                                                     const FilterModeSettings&, FilterLanes&);
+    using LanesFilterFn = SIMDFloat (*) (SIMDFloat, SIMDFloat, SIMDFloat, SIMDFloat,
+                                         const FilterModeSettings&, FilterLanes&);
+   #endif
+
+    struct FilterKernels
+    {
+        MonoFilterFn mono = nullptr;
+       #if JUCE_USE_SIMD
+        StereoFilterFn stereo = nullptr;
+        LanesFilterFn lanes = nullptr;
+       #endif
+    };
+
+    template <size_t Index>
+    static constexpr FilterKernels makeFilterKernels()
+    {
+        constexpr bool oversample  = (Index & 1) != 0;
+        constexpr bool clampStages = (Index & 2) != 0;
+        constexpr bool asym        = (Index & 4) != 0;
+        constexpr bool resComp     = (Index & 8) != 0;
+
+        FilterKernels kernels;
+        kernels.mono = &processFilterKernel<oversample, clampStages, asym, resComp>;
+       #if JUCE_USE_SIMD
+        kernels.stereo = &processFilterStereoKernel<oversample, clampStages, asym, resComp>;
+        kernels.lanes = &processFilterLanesKernel<oversample, clampStages, asym, resComp>;
+       #endif
+        return kernels;
+    }
+
+    template <size_t... Index>
+    static constexpr std::array<FilterKernels, sizeof... (Index)> makeFilterKernelTable (std::index_sequence<Index...>)
+    {
+        return {{ makeFilterKernels<Index>()... }};
+    }
+
+    static inline FilterKernels getFilterKernels (const FilterModeSettings& mode)
+    {
+        static constexpr auto table = makeFilterKernelTable (std::make_index_sequence<16>());
+
+        const size_t index = (mode.oversample ? 1u : 0u)
+                           | (mode.clampStages ? 2u : 0u)
+                           | (mode.asym > 0.001f ? 4u : 0u)
+                           | (mode.resComp > 0.0f ? 8u : 0u);
+        return table[index];
+    }
+
+    // Continuous controls that are smoothed with a ParameterRamp rather than
+    // stepping at block boundaries.
+    struct Controls
+    {
+        float cutoff = 800.0f;  // Hz
+        float res = 0.0f;       // 0..1
+        float drive = 0.0f;     // 0..1
+        float sat = 0.0f;       // 0..1
+        float gain = 0.2f;      // linear
+    };
+
+    // Values that stay constant for a whole render block.
+    struct BlockConstants
+    {
+        float glideCoef = 0.0f;
+        float unisonAmt = 0.0f;     // 0 unless there are unison oscillators to play
+        float subAmt = 0.0f;
+        float spread = 0.0f;
+        float mainWeight = 1.0f;
+
+        // the smoothed controls: settled values, plus per-sample values for
+        // each control that is ramping during this block (nullptr otherwise)
+        Controls controls;
+        const float* cutoffRamp = nullptr;
+        const float* resRamp = nullptr;
+        const float* driveRamp = nullptr;
+        const float* satRamp = nullptr;
+        const float* gainRamp = nullptr;
+
+        Controls controlsAt (int i) const noexcept
+        {
+            Controls c = controls;
+            if (cutoffRamp != nullptr) c.cutoff = cutoffRamp[i];
+            if (resRamp != nullptr)    c.res = resRamp[i];
+            if (driveRamp != nullptr)  c.drive = driveRamp[i];
+            if (satRamp != nullptr)    c.sat = satRamp[i];
+            if (gainRamp != nullptr)   c.gain = gainRamp[i];
+            return c;
+        }
+
+        // pan gains are only precomputed while nothing in the matrix modulates pan
+        bool panModulated = false;
+        PanGains mainPan;
+
+        // no pan modulation and no unison: left and right carry the same signal
+        bool centred = false;
+
+        // filter character (and its kernels) only precomputed while it is not morphing
+        bool filterModeStatic = false;
+        FilterModeSettings mode;
+        FilterKernels kernels;
+    };
+
+    // numSamples (at most maxBlockSize) is the length of the block about to be
+    // rendered: the control ramps are advanced over it.
+    BlockConstants beginBlock (int numSamples)
+    {
+        auto constants = makeBlockConstants();
+        constants.cutoffRamp = cutoffRamp.process (numSamples);
+        constants.resRamp = resRamp.process (numSamples);
+        constants.driveRamp = driveRamp.process (numSamples);
+        constants.satRamp = satRamp.process (numSamples);
+        constants.gainRamp = gainRamp.process (numSamples);
+
+        syncFilterLayout (constants.centred);
+        return constants;
+    }
+
+    BlockConstants makeBlockConstants()
+    {
+        BlockConstants c;
+
+        const float glideSec = juce::jmax (0.0f, glideMs) * 0.001f;
+        c.glideCoef = glideCoefCache.get (glideSec, sr);
+
+        c.unisonAmt = (unisonVoices > 1) ? juce::jlimit (0.0f, 1.0f, unison) : 0.0f;
+        c.subAmt = juce::jlimit (0.0f, 1.0f, subMix);
+        c.spread = juce::jlimit (0.0f, 1.0f, unisonSpread) * (0.35f + 0.65f * c.unisonAmt);
+        c.mainWeight = 1.0f - 0.35f * c.unisonAmt;
+        c.controls.cutoff = cutoffRamp.getTargetValue();
+        c.controls.res = resRamp.getTargetValue();
+        c.controls.drive = driveRamp.getTargetValue();
+        c.controls.sat = satRamp.getTargetValue();
+        c.controls.gain = gainRamp.getTargetValue();
+
+        c.panModulated = std::any_of (slots.begin(), slots.end(), [] (const ModSlot& slot)
+        {
+            return slot.dest == 5 && slot.source != 0 && slot.amount != 0.0f;
+        });
+
+        if (! c.panModulated)
+            c.mainPan = getPanGains (0.0f);
+
+        if (c.unisonAmt > 0.0001f)
+        {
+            updateUnisonLayout (unisonVoices, c.unisonAmt, c.spread);
+
+            // an even count has no centre voice; the layout carries all of them
+            if (unisonVoices % 2 == 0)
+                c.mainWeight = 0.0f;
+        }
+
+        unisonPanModulated = c.panModulated && c.unisonAmt > 0.0001f;
+        if (! unisonPanModulated)
+            unisonPanValid = false;
+        else if (! unisonPanValid)
+            beginUnisonPanStep (controlFrame.pan, 1);  // holds until the next control step
+
+        c.centred = ! c.panModulated && c.unisonAmt <= 0.0001f;
+
+        c.filterModeStatic = ! filterCharSmoothed.isSmoothing();
+        if (c.filterModeStatic)
+        {
+            c.mode = getMorphedFilterMode (filterCharSmoothed.getTargetValue());
+            c.kernels = getFilterKernels (c.mode);
+        }
+
+        return c;
+    }
+
+    static inline FilterModeSettings getMorphedFilterMode (float charIndex)
+    {
+        const int idx0 = juce::jlimit (0, 4, (int) std::floor (charIndex));
+        const int idx1 = juce::jlimit (0, 4, idx0 + 1);
+        const float charMix = juce::jlimit (0.0f, 1.0f, charIndex - (float) idx0);
+
+        const auto modeA = getFilterModeSettings (idx0);
+        const auto modeB = getFilterModeSettings (idx1);
+
+        auto lerp = [] (float a, float b, float t)
+        {
+            return a + (b - a) * t;
+        };
+
+        FilterModeSettings mode {};
+        mode.kScale = lerp (modeA.kScale, modeB.kScale, charMix);
+        mode.kGScale = lerp (modeA.kGScale, modeB.kGScale, charMix);
+        mode.feedbackDrive = lerp (modeA.feedbackDrive, modeB.feedbackDrive, charMix);
+        mode.stageClip = lerp (modeA.stageClip, modeB.stageClip, charMix);
+        mode.asym = lerp (modeA.asym, modeB.asym, charMix);
+        mode.resComp = lerp (modeA.resComp, modeB.resComp, charMix);
+        mode.oversample = modeA.oversample || modeB.oversample;
+        mode.clampStages = modeA.clampStages || modeB.clampStages;
+        return mode;
+    }
+
+    // Everything the modulation stage hands to the audio-rate voice loop.
+    // In control-rate mode these are ramped linearly between control steps.
+    struct ModFrame
+    {
+        float accentTotal = 0.0f;
+        float envCoef = 0.0f;
+        float modEnvCoef = 0.0f;
+        float pitchRatio = 1.0f;
+        float cutoff = 0.0f;
+        float drive = 0.0f;
+        float gain = 0.0f;
+        float pan = 0.0f;
+        float panLeft = 0.0f;   // main oscillator and sub gains for pan
+        float panRight = 0.0f;
+        float res = 0.0f;
+    };
+
+    static inline void advanceFrame (ModFrame& frame, const ModFrame& step)
+    {
+        frame.accentTotal += step.accentTotal;
+        frame.envCoef += step.envCoef;
+        frame.modEnvCoef += step.modEnvCoef;
+        frame.pitchRatio += step.pitchRatio;
+        frame.cutoff += step.cutoff;
+        frame.drive += step.drive;
+        frame.gain += step.gain;
+        frame.pan += step.pan;
+        frame.panLeft += step.panLeft;
+        frame.panRight += step.panRight;
+        frame.res += step.res;
+    }
+
+    static inline ModFrame getFrameStep (const ModFrame& from, const ModFrame& to, int numSteps)
+    {
+        const float inv = 1.0f / (float) numSteps;
+        ModFrame step;
+        step.accentTotal = (to.accentTotal - from.accentTotal) * inv;
+        step.envCoef = (to.envCoef - from.envCoef) * inv;
+        step.modEnvCoef = (to.modEnvCoef - from.modEnvCoef) * inv;
+        step.pitchRatio = (to.pitchRatio - from.pitchRatio) * inv;
+        step.cutoff = (to.cutoff - from.cutoff) * inv;
+        step.drive = (to.drive - from.drive) * inv;
+        step.gain = (to.gain - from.gain) * inv;
+        step.pan = (to.pan - from.pan) * inv;
+        step.panLeft = (to.panLeft - from.panLeft) * inv;
+        step.panRight = (to.panRight - from.panRight) * inv;
+        step.res = (to.res - from.res) * inv;
+        return step;
+    }
+
+    static inline float advanceSmoothed (juce::SmoothedValue<float>& value, int numSteps)
+    {
+        return (numSteps == 1) ? value.getNextValue() : value.skip (numSteps);
+    }
+
+    // Advances LFOs, accent and the accent kick by numSteps samples and evaluates
+    // the mod matrix at the new position.
+    ModFrame evaluateModulation (int numSteps)
+    {
+        // --- modulation sources ---
+        const float lfo1RateStep = advanceSmoothed (lfo1FreqSmoothed, numSteps);
+        const float lfo2RateStep = advanceSmoothed (lfo2FreqSmoothed, numSteps);
+        lfo1Phase += lfo1RateStep * (float) numSteps / sr;
+        lfo2Phase += lfo2RateStep * (float) numSteps / sr;
+        if (lfo1Phase >= 1.0f) lfo1Phase -= 1.0f;
+        if (lfo2Phase >= 1.0f) lfo2Phase -= 1.0f;
+
+        const float lfo1 = DspMath::sin (juce::MathConstants<float>::twoPi * lfo1Phase);
+        const float lfo2 = DspMath::sin (juce::MathConstants<float>::twoPi * (lfo2Phase + 0.25f));
+
+        // --- Accent macro (velocity + Accent parameter) ---
+        // Accent shapes multiple targets like a classic 303: cutoff/res/envmod/drive/decay.
+        const float accentGate = (vel > 0.7f) ? 1.0f : 0.0f;
+        const float accentTarget = juce::jlimit (0.0f, 1.0f, accent * accentGate);
+        accentSmoothed.setTargetValue (accentTarget);
+        const float accentBase = advanceSmoothed (accentSmoothed, numSteps);
+        const float accentShaped = accentShapeCache.get (accentBase);
+
+        const float accentKickValue = accentKick;
+        accentKick *= (numSteps == 1) ? accentKickCoef : controlKickCoef;
+        if (accentKick < 1.0e-5f)
+            accentKick = 0.0f;
+
+        ModFrame frame;
+        frame.accentTotal = juce::jlimit (0.0f, 1.0f, accentShaped + 0.35f * accentKickValue);
+
+        // --- envelope decay (accent slightly tightens decay times) ---
+        const float decayScaled = juce::jmax (0.01f, decay * (1.0f - 0.25f * frame.accentTotal));
+        const float modDecayScaled = juce::jmax (0.01f, modEnvDecay * (1.0f - 0.15f * frame.accentTotal));
+        frame.envCoef = envCoefCache.get (decayScaled, sr);
+        frame.modEnvCoef = modEnvCoefCache.get (modDecayScaled, sr);
+
+        // the audio-rate path reads the mod env after this sample's decay step
+        const float modEnvValue = (numSteps == 1) ? modEnv * frame.modEnvCoef : modEnv;
+
+        float modPitch = 0.0f;
+
+        for (const auto& slot : slots)
+        {
+            const float source = getSourceValue (slot.source, lfo1, lfo2, modEnvValue);
+            const float amount = slot.amount;
+
+            switch (slot.dest)
+            {
+                case 1: // Cutoff
+                    frame.cutoff += source * amount * 6000.0f;
+                    break;
+                case 2: // Pitch
+                    modPitch += source * amount * 12.0f;
+                    break;
+                case 3: // Drive
+                    frame.drive += source * amount * 0.45f;
+                    break;
+                case 4: // Gain
+                    frame.gain += source * amount * 0.5f;
+                    break;
+                case 5: // Pan
+                    frame.pan += source * amount;
+                    break;
+                case 6: // Resonance
+                    frame.res += source * amount * 0.35f;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        frame.pitchRatio = CoefficientTables::get().pitchRatio (modPitch);
+
+        // the base pan is limited before the unison offsets spread around it
+        frame.pan = juce::jlimit (-1.0f, 1.0f, frame.pan);
+
+        // pan gains are looked up here, once per control step, and ramped with the rest of the frame
+        const auto panGains = getPanGains (frame.pan);
+        frame.panLeft = panGains.left;
+        frame.panRight = panGains.right;
+
+        if (unisonPanModulated)
+            beginUnisonPanStep (frame.pan, numSteps);
+
+        return frame;
+    }
+
+    // Starts the next control-rate segment: evaluates the matrix at its end and
+    // sets up the per-sample ramp towards it.
+    void beginControlStep()
+    {
+        const auto target = evaluateModulation (controlInterval);
+
+        if (! controlFrameValid)
+        {
+            controlFrame = target;
+            controlFrameValid = true;
+        }
+
+        controlStep = getFrameStep (controlFrame, target, controlInterval);
+        controlCountdown = controlInterval;
+    }
+
+    std::array<float, 2> renderSample (const BlockConstants& bc)
+    {
+        return renderVoice (bc, evaluateModulation (1), 0);
+    }
+
+    // Runs the modulation stage for numSamples samples (per sample, or ramped at
+    // control rate) and calls voiceFn (sampleIndex, frame) for each of them.
+    template <typename VoiceFn>
+    void runModulation (int numSamples, VoiceFn&& voiceFn)
+    {
+        if (controlInterval <= 1)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                voiceFn (i, evaluateModulation (1));
+
+            return;
+        }
+
+        // control-rate: the mod matrix runs once per segment, the voice ramps through it
+        for (int i = 0; i < numSamples;)
+        {
+            if (controlCountdown <= 0)
+                beginControlStep();
+
+            const int n = juce::jmin (controlCountdown, numSamples - i);
+            for (int end = i + n; i < end; ++i)
+            {
+                advanceFrame (controlFrame, controlStep);
+                voiceFn (i, controlFrame);
+            }
+
+            controlCountdown -= n;
+        }
+    }
+
+    static inline void writeOutput (float* left, float* right, int i, const std::array<float, 2>& s)
+    {
+        if (right != nullptr)
+        {
+            left[i] = s[0];
+            right[i] = s[1];
+        }
+        else
+        {
+            left[i] = 0.5f * (s[0] + s[1]);
+        }
+    }
+
+    // What the oscillator and modulation stage hands to the ladder for one sample.
+    struct LadderInput
+    {
+        float left = 0.0f;          // pre-gained ladder input (the only channel while centred)
+        float right = 0.0f;
+        float fc = 20.0f;           // Hz
+        float kBase = 0.0f;
+        float outScale = 0.0f;      // amp env, accent and gain, applied after the nonlinear stages
+        float filterChar = 0.0f;    // morph position, only set while filterCharSmoothed ramps
+    };
+
+    // The audio-rate part of the voice: oscillators, envelopes, filter and gain.
+    // i is the sample's index in the block, for the smoothed controls.
+    LadderInput renderOscillators (const BlockConstants& bc, const ModFrame& mod, int i)
+    {
+        const auto ctl = bc.controlsAt (i);
+
+        // --- glide (as in your original code) ---
+        if (glideActive)
+            currentFreq = bc.glideCoef * currentFreq + (1.0f - bc.glideCoef) * targetFreq;
+        else
+            currentFreq = targetFreq;
+
+        const float accentTotal = mod.accentTotal;
+        env *= mod.envCoef;
+        modEnv *= mod.modEnvCoef;
+
+        if (gate)
+        {
+            releaseEnv = 1.0f;
+            releaseActive = false;
+        }
+        else if (releaseActive)
+        {
+            if (releaseCoef <= 0.0f)
+            {
+                releaseEnv = 0.0f;
+            }
+            else
+            {
+                releaseEnv *= releaseCoef;
+                if (releaseEnv < 1.0e-4f)
+                    releaseEnv = 0.0f;
+            }
+
+            if (releaseEnv == 0.0f)
+                releaseActive = false;
+        }
+
+        const float modulatedFreq = currentFreq * mod.pitchRatio;
+
+        // --- oscillator: band-limited saw -> square morph (same idea as before) ---
+        const float dt = juce::jmin (0.5f, modulatedFreq / sr);
+        phase += dt;
+        if (phase >= 1.0f) phase -= 1.0f;
+
+        float oscMain = renderWave (phase, dt, wave);
+
+        if (bc.subAmt > 0.0001f)
+        {
+            phaseSub += (modulatedFreq * 0.5f) / sr;
+            if (phaseSub >= 1.0f) phaseSub -= 1.0f;
+        }
+
+        // --- cutoff with envelope modulation (accent opens cutoff and boosts env depth) ---
+        // envmod maps to an added cutoff range.
+        const float cutoffAccent = ctl.cutoff * (1.0f + 1.2f * accentTotal);
+        const float envmodAccent = envmod * (1.0f + 0.6f * accentTotal);
+        float fc = cutoffAccent + envmodAccent * 5000.0f * env + mod.cutoff;
+        fc = juce::jlimit (20.0f, 16000.0f, fc);
+
+        LadderInput in;
+        in.fc = fc;
+
+        // Resonance amount. This is "by ear" scaling.
+        // Make sure the full knob range is audibly effective.
+        // Too high without clipping can explode, so we soft-clip the loop.
+        const float resAccented = juce::jlimit (0.0f, 0.995f, ctl.res + mod.res + 0.08f * accentTotal);
+        const float resNorm = juce::jlimit (0.0f, 1.0f, resAccented);
+        const float resCurve = CoefficientTables::get().resCurve (resNorm);
+        in.kBase = juce::jmap (resCurve, 0.0f, 1.0f, 0.0f, 4.8f);
+
+        // Drive: pre-gain into the ladder core
+        const float driveAccent = ctl.drive * (1.0f + 1.0f * accentTotal);
+        float driveAmt = juce::jlimit (0.0f, 1.0f, driveAccent + mod.drive);
+        float pre = 1.0f + 6.0f * driveAmt;
+
+        if (! bc.filterModeStatic)
+            in.filterChar = filterCharSmoothed.getNextValue();
+
+        const float sub = (bc.subAmt > 0.0001f)
+                              ? bc.subAmt * 0.8f * DspMath::sin (juce::MathConstants<float>::twoPi * phaseSub)
+                              : 0.0f;
+
+        // modest accent gain bump (the main accent impact is tone/drive/decay)
+        const float acc = 1.0f + 0.2f * accentTotal;
+
+        float outGain = juce::jlimit (0.0f, 2.0f, ctl.gain + mod.gain);
+
+        const float ampEnv = env * releaseEnv;
+        in.outScale = ampEnv * acc * outGain;
+
+        if (bc.centred)
+        {
+            // both channels would see the same signal: only one ladder runs
+            const float osc = (oscMain * bc.mainWeight + sub) * bc.mainPan.left;
+            in.left = in.right = osc * pre;
+            return in;
+        }
+
+        float oscLeft = 0.0f;
+        float oscRight = 0.0f;
+
+        const PanGains pan = bc.panModulated ? PanGains { mod.panLeft, mod.panRight } : bc.mainPan;
+
+        addPanned (oscLeft, oscRight, oscMain * bc.mainWeight, pan);
+
+        if (bc.unisonAmt > 0.0001f)
+            renderUnison (bc.panModulated, dt, oscLeft, oscRight);
+
+        if (bc.subAmt > 0.0001f)
+            addPanned (oscLeft, oscRight, sub, pan);
+
+        in.left = oscLeft * pre;
+        in.right = oscRight * pre;
+        return in;
+    }
+
+    // The nonlinear output stages after the ladder.
+    static inline float shapeOutput (float y, float satAmt)
+    {
+        // optional output saturation (kept from your original "drive coloration")
+        y = DspMath::tanh (y);
+
+        // post-filter drive stage for extra power
+        if (satAmt > 0.0001f)
+            y = softClip (y * (1.0f + 8.0f * satAmt));
+
+        return y;
+    }
+
+   #if JUCE_USE_SIMD
+    static inline SIMDFloat shapeOutput (SIMDFloat y, float satAmt)
+    {
+        y = DspMath::tanh (y);
+
+        if (satAmt > 0.0001f)
+            y = softClip (y * (1.0f + 8.0f * satAmt), 0.8f);
+
+        return y;
+    }
+   #endif
+
+    // Runs one sample of the ladder and output shaping at filterRate. Returns the
+    // shaped but unscaled output; right is unused while centred.
+    std::array<float, 2> runLadder (const BlockConstants& bc, float left, float right, float fc, float kBase, float satAmt,
+                                    const FilterModeSettings& mode, const FilterKernels& kernels, float filterRate)
+    {
+        // Coefficient for one-pole stage: g = 1 - exp(-2*pi*fc/sr), read from the shared table
+        const auto& tables = CoefficientTables::get();
+        const float g = tables.onePoleG (fc / filterRate);
+        const float gOs = tables.onePoleG (fc / (filterRate * 2.0f));
+
+        if (bc.centred)
+        {
+            const float y = shapeOutput (kernels.mono (left, kBase, g, gOs, mode, filterMono), satAmt);
+            return { y, y };
+        }
+
+       #if JUCE_USE_SIMD
+        const auto filtered = kernels.stereo (left, right, kBase, g, gOs, mode, filterStereo);
+        return { shapeOutput (filtered[0], satAmt), shapeOutput (filtered[1], satAmt) };
+       #else
+        return { shapeOutput (kernels.mono (left, kBase, g, gOs, mode, filterL), satAmt),
+                 shapeOutput (kernels.mono (right, kBase, g, gOs, mode, filterR), satAmt) };
+       #endif
+    }
+
+    std::array<float, 2> renderVoice (const BlockConstants& bc, const ModFrame& mod, int i)
+    {
+        const auto in = renderOscillators (bc, mod, i);
+        const float satAmt = (bc.satRamp != nullptr) ? bc.satRamp[i] : bc.controls.sat;
+
+        const auto mode = bc.filterModeStatic ? bc.mode : getMorphedFilterMode (in.filterChar);
+        const auto kernels = bc.filterModeStatic ? bc.kernels : getFilterKernels (mode);
+
+        const auto y = runLadder (bc, in.left, in.right, in.fc, in.kBase, satAmt, mode, kernels, sr);
+        const float left = y[0] * in.outScale;
+        return { left, bc.centred ? left : y[1] * in.outScale };
+    }
+
+    // Block path with the nonlinear section oversampled: the oscillators and
+    // modulation run at the base rate into scratch buffers, the ladder input is
+    // upsampled, the ladder and output shaping run at the oversampled rate and
+    // the result is decimated before the (linear) output gain. The decimated
+    // signal lags by the resampler latency, so the gains are delayed to match:
+    // scratchScale keeps the last latency values of the previous block in
+    // front of this block's.
+    void renderOversampled (const BlockConstants& bc, float* left, float* right, int numSamples)
+    {
+        auto& os = *activeOversampler;
+        const int factor = (int) os.getOversamplingFactor();
+        const float filterRate = sr * (float) factor;
+        const int latency = getLatencySamples();
+
+        float* inLeft = scratchLeft.data();
+        float* inRight = scratchRight.data();
+        float* scaleIn = scratchScale.data() + latency;
+
+        runModulation (numSamples, [&] (int i, const ModFrame& mod)
+        {
+            const auto in = renderOscillators (bc, mod, i);
+            inLeft[i] = in.left;
+            inRight[i] = in.right;
+            scratchFc[(size_t) i] = in.fc;
+            scratchK[(size_t) i] = in.kBase;
+            scaleIn[i] = in.outScale;
+            scratchChar[(size_t) i] = in.filterChar;
+        });
+
+        // while centred the right resampler channel runs on a copy of the left,
+        // so its filter state is the left one's when the block turns stereo again
+        if (bc.centred)
+            std::copy (inLeft, inLeft + numSamples, inRight);
+
+        float* channels[] = { inLeft, inRight };
+        juce::dsp::AudioBlock<float> block (channels, 2, (size_t) numSamples);
+        auto upBlock = os.processSamplesUp (block);
+
+        float* upLeft = upBlock.getChannelPointer (0);
+        float* upRight = upBlock.getChannelPointer (1);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto mode = bc.filterModeStatic ? bc.mode : getMorphedFilterMode (scratchChar[(size_t) i]);
+            const auto kernels = bc.filterModeStatic ? bc.kernels : getFilterKernels (mode);
+            const float fc = scratchFc[(size_t) i];
+            const float kBase = scratchK[(size_t) i];
+            const float satAmt = (bc.satRamp != nullptr) ? bc.satRamp[i] : bc.controls.sat;
+
+            for (int j = i * factor, end = j + factor; j < end; ++j)
+            {
+                const auto y = runLadder (bc, upLeft[j], upRight[j], fc, kBase, satAmt, mode, kernels, filterRate);
+                upLeft[j] = y[0];
+                upRight[j] = y[1];
+            }
+        }
+
+        os.processSamplesDown (block);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float outScale = scratchScale[(size_t) i];
+            const float l = inLeft[i] * outScale;
+            const float r = bc.centred ? l : inRight[i] * outScale;
+            writeOutput (left, right, i, { l, r });
+        }
+
+        std::copy (scratchScale.begin() + numSamples, scratchScale.begin() + numSamples + latency, scratchScale.begin());
+    }
+
+    //==============================================================================
+    // Lanes: one float per oscillator or voice, laneWidth of them per SIMD
+    // register (or a plain float without SIMD). Poly voices and unison
+    // oscillators are stored as structures of arrays and processed a register
+    // at a time; poly ladders live in FilterLanes.
+   #if JUCE_USE_SIMD
+    using Lanes = SIMDFloat;
+    using PolyFilterState = FilterLanes;
+    static constexpr int laneWidth = (int) SIMDFloat::size();
+   #else
+    using Lanes = float;
+    using PolyFilterState = FilterState;
+    static constexpr int laneWidth = 1;
+   #endif
+    static constexpr int numPolyGroups = maxPolyVoices / laneWidth;
+
+    struct PolyVoices
+    {
+        alignas (32) std::array<float, maxPolyVoices> phase {};
+        alignas (32) std::array<float, maxPolyVoices> subPhase {};
+        alignas (32) std::array<float, maxPolyVoices> increment {};   // note frequency / sr
+        alignas (32) std::array<float, maxPolyVoices> env {};
+        alignas (32) std::array<float, maxPolyVoices> releaseEnv {};  // 1 while held, 0 once free
+        alignas (32) std::array<float, maxPolyVoices> releaseMul {};  // per-sample releaseEnv factor
+        std::array<int, maxPolyVoices> note {};
+        std::array<bool, maxPolyVoices> gate {};
+        std::array<uint32_t, maxPolyVoices> startedAt {};
+        std::array<PolyFilterState, (size_t) numPolyGroups> filter {};
+    };
+
+   #if JUCE_USE_SIMD
+    static inline SIMDFloat splatLanes (float x)                 { return SIMDFloat::expand (x); }
+    static inline SIMDFloat loadLanes (const float* p)           { return SIMDFloat::fromRawArray (p); }
+    static inline void storeLanes (float* p, SIMDFloat v)        { v.copyToRawArray (p); }
+    static inline SIMDFloat wrapPhase (SIMDFloat p)              { return p - SIMDFloat::truncate (p); }
+    static inline float sumLanes (SIMDFloat v)                   { return v.sum(); }
+
+    static inline SIMDFloat zeroBelow (SIMDFloat v, float threshold)
+    {
+        return v & SIMDFloat::greaterThanOrEqual (v, SIMDFloat::expand (threshold));
+    }
+
+    static inline SIMDFloat lookupLanes (const juce::dsp::LookupTableTransform<float>& table, SIMDFloat x)
+    {
+        for (size_t i = 0; i < SIMDFloat::size(); ++i)
+            x.set (i, table (x.get (i)));
+
+        return x;
+    }
+
+    static inline SIMDFloat runPolyLadder (const FilterKernels& kernels, SIMDFloat input, float kBase, SIMDFloat g,
+                                           SIMDFloat gOs, const FilterModeSettings& mode, FilterLanes& state)
+    {
+        return kernels.lanes (input, SIMDFloat::expand (kBase), g, gOs, mode, state);
+    }
+   #else
+    static inline float splatLanes (float x)                     { return x; }
+    static inline float loadLanes (const float* p)               { return *p; }
+    static inline void storeLanes (float* p, float v)            { *p = v; }
+    static inline float wrapPhase (float p)                      { return p - (float) (int) p; }
+    static inline float sumLanes (float v)                       { return v; }
+    static inline float zeroBelow (float v, float threshold)     { return (v < threshold) ? 0.0f : v; }
+
+    static inline float lookupLanes (const juce::dsp::LookupTableTransform<float>& table, float x)
+    {
+        return table (x);
+    }
+
+    static inline float runPolyLadder (const FilterKernels& kernels, float input, float kBase, float g, float gOs,
+                                       const FilterModeSettings& mode, FilterState& state)
+    {
+        return kernels.mono (input, kBase, g, gOs, mode, state);
+    }
+   #endif
+
+    // renderWave() without branches: the BLEP residuals come from clamped ramps,
+    // so the same code serves one voice or a register of them.
+    static inline Lanes polyBlepLanes (Lanes t, Lanes invDt)
+    {
+        const Lanes rise = FastMath::clamp (t * invDt, 0.0f, 1.0f) * -1.0f + 1.0f;   // 1 - t/dt near 0, else 0
+        const Lanes fall = FastMath::clamp ((t - 1.0f) * invDt, -1.0f, 0.0f) + 1.0f; // 1 + (t-1)/dt near 1, else 0
+        return fall * fall - rise * rise;
+    }
+
+    static inline Lanes renderWaveLanes (Lanes p, Lanes dt, float morph)
+    {
+        const Lanes invDt = FastMath::divide (splatLanes (1.0f), FastMath::clamp (dt, 1.0e-9f, 0.5f));
+        const Lanes saw = p * 2.0f - 1.0f - polyBlepLanes (p, invDt);
+
+        // a square is the difference of two saws half a cycle apart
+        const Lanes pHalf = wrapPhase (p + 0.5f);
+        const Lanes sawHalf = pHalf * 2.0f - 1.0f - polyBlepLanes (pHalf, invDt);
+        const Lanes sq = sawHalf - saw;
+
+        return saw + (sq - saw) * morph;
+    }
+
+    // Per-oscillator detune ratio, gain and static pan of the unison
+    // oscillators (all but the main one), padded with silent entries to a
+    // whole number of lanes.
+    struct UnisonLayout
+    {
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> ratio {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> gain {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> panOffset {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> panLeft {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> panRight {};
+        int numActive = 0;
+
+        int lastCount = -1;
+        float lastAmount = -1.0f;
+        float lastSpread = -1.0f;
+    };
+
+    // Oscillator k sits at +-(k / 2 + 1) / numPairs of the full detune and
+    // spread, alternating sides, so three voices reproduce the classic
+    // main-plus-two layout. An even count puts every oscillator in the pairs
+    // (the main one is muted, see makeBlockConstants()) and shares the main
+    // oscillator's level between them by power. Only recomputed when the
+    // settings change.
+    void updateUnisonLayout (int count, float amount, float spread)
+    {
+        auto& u = unisonLayout;
+        if (count == u.lastCount && amount == u.lastAmount && spread == u.lastSpread)
+            return;
+
+        u.lastCount = count;
+        u.lastAmount = amount;
+        u.lastSpread = spread;
+        unisonPanValid = false;
+
+        const bool centreVoice = (count % 2) != 0;
+        const int sides = centreVoice ? count - 1 : count;
+        const int numPairs = sides / 2;
+        const float detuneCents = 7.0f + 25.0f * amount;
+        const float pairGain = 0.175f * amount;
+        const float mainWeight = 1.0f - 0.35f * amount;
+        const float sideGain = centreVoice ? pairGain * std::sqrt (2.0f / (float) sides)
+                                           : std::sqrt ((mainWeight * mainWeight + 2.0f * pairGain * pairGain) / (float) sides);
+
+        u.numActive = ((sides + laneWidth - 1) / laneWidth) * laneWidth;
+
+        for (int k = 0; k < maxUnisonVoices; ++k)
+        {
+            const auto i = (size_t) k;
+
+            if (k >= sides)
+            {
+                u.ratio[i] = 1.0f;
+                u.gain[i] = 0.0f;
+                u.panOffset[i] = u.panLeft[i] = u.panRight[i] = 0.0f;
+                continue;
+            }
+
+            const float position = ((k % 2 == 0) ? 1.0f : -1.0f) * (float) (k / 2 + 1) / (float) numPairs;
+            const auto pan = getPanGains (-position * spread);
+
+            u.ratio[i] = std::pow (2.0f, position * detuneCents / 1200.0f);
+            u.gain[i] = sideGain;
+            u.panOffset[i] = -position * spread;
+            u.panLeft[i] = pan.left;
+            u.panRight[i] = pan.right;
+        }
+    }
+
+    // Per-oscillator pan gains of the unison oscillators while pan is
+    // modulated. Like controlFrame they are looked up once per control step
+    // and ramped linearly through it: each sample adds the step, then uses them.
+    struct UnisonPanRamp
+    {
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> left {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> right {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> leftStep {};
+        alignas (32) std::array<float, (size_t) maxUnisonVoices> rightStep {};
+    };
+
+    // Sets the unison pan gains ramping to their values at basePan over the
+    // next numSteps samples (or holding them there if they were not valid).
+    void beginUnisonPanStep (float basePan, int numSteps)
+    {
+        auto& r = unisonPanRamp;
+        const float inv = 1.0f / (float) numSteps;
+
+        for (size_t k = 0; k < (size_t) unisonLayout.numActive; ++k)
+        {
+            const auto target = getPanGains (unisonLayout.panOffset[k] + basePan);
+
+            if (unisonPanValid)
+            {
+                r.leftStep[k] = (target.left - r.left[k]) * inv;
+                r.rightStep[k] = (target.right - r.right[k]) * inv;
+            }
+            else
+            {
+                r.left[k] = target.left;
+                r.right[k] = target.right;
+                r.leftStep[k] = r.rightStep[k] = 0.0f;
+            }
+        }
+
+        unisonPanValid = true;
+    }
+
+    // Advances every unison oscillator by one sample (dt is the main oscillator's
+    // phase increment) and adds their panned sum to left and right.
+    void renderUnison (bool panModulated, float dt, float& left, float& right)
+    {
+        Lanes sumLeft = splatLanes (0.0f);
+        Lanes sumRight = splatLanes (0.0f);
+
+        for (size_t base = 0; base < (size_t) unisonLayout.numActive; base += (size_t) laneWidth)
+        {
+            const Lanes increment = FastMath::clamp (loadLanes (&unisonLayout.ratio[base]) * dt, 0.0f, 0.5f);
+            const Lanes phases = wrapPhase (loadLanes (&unisonPhase[base]) + increment);
+            storeLanes (&unisonPhase[base], phases);
+
+            const Lanes osc = renderWaveLanes (phases, increment, wave) * loadLanes (&unisonLayout.gain[base]);
+
+            if (panModulated)
+            {
+                const Lanes panLeft = loadLanes (&unisonPanRamp.left[base]) + loadLanes (&unisonPanRamp.leftStep[base]);
+                const Lanes panRight = loadLanes (&unisonPanRamp.right[base]) + loadLanes (&unisonPanRamp.rightStep[base]);
+                storeLanes (&unisonPanRamp.left[base], panLeft);
+                storeLanes (&unisonPanRamp.right[base], panRight);
+                sumLeft += osc * panLeft;
+                sumRight += osc * panRight;
+            }
+            else
+            {
+                sumLeft += osc * loadLanes (&unisonLayout.panLeft[base]);
+                sumRight += osc * loadLanes (&unisonLayout.panRight[base]);
+            }
+        }
+
+        left += sumLanes (sumLeft);
+        right += sumLanes (sumRight);
+    }
+
+    // Same note retriggers its voice; otherwise a free voice, then the oldest
+    // released one, then the oldest held one.
+    int findPolyVoice (int midiNote) const
+    {
+        for (int v = 0; v < polyVoiceCount; ++v)
+            if (poly.note[(size_t) v] == midiNote && poly.releaseEnv[(size_t) v] > 0.0f)
+                return v;
+
+        for (int v = 0; v < polyVoiceCount; ++v)
+            if (poly.releaseEnv[(size_t) v] <= 0.0f)
+                return v;
+
+        int oldest = 0;
+        bool oldestReleased = false;
+
+        for (int v = 0; v < polyVoiceCount; ++v)
+        {
+            const bool released = ! poly.gate[(size_t) v];
+            const bool older = poly.startedAt[(size_t) v] < poly.startedAt[(size_t) oldest];
+
+            if ((released && ! oldestReleased) || (released == oldestReleased && older))
+            {
+                oldest = v;
+                oldestReleased = released;
+            }
+        }
+
+        return oldest;
+    }
+
+    void polyNoteOn (int midiNote, float velocity)
+    {
+        const auto v = (size_t) findPolyVoice (midiNote);
+
+        poly.note[v] = midiNote;
+        poly.gate[v] = true;
+        poly.startedAt[v] = ++polyNoteCounter;
+        poly.increment[v] = (float) juce::MidiMessage::getMidiNoteInHertz (midiNote) / sr;
+        poly.phase[v] = 0.0f;
+        poly.subPhase[v] = 0.0f;
+        poly.env[v] = 1.0f;
+        poly.releaseEnv[v] = 1.0f;
+
+        // the shared modulation (accent, mod env) follows the latest note
+        vel = velocity;
+        modEnv = 1.0f;
+    }
+
+    void polyNoteOff (int midiNote)
+    {
+        for (size_t v = 0; v < (size_t) maxPolyVoices; ++v)
+        {
+            if (poly.note[v] == midiNote && poly.gate[v])
+            {
+                poly.gate[v] = false;
+                if (releaseCoef <= 0.0f)
+                    poly.releaseEnv[v] = 0.0f;
+            }
+        }
+    }
+
+    // Per-sample values shared by every poly voice, filled by the modulation pass.
+    struct PolyFrame
+    {
+        float pitchRatio = 1.0f;
+        float envCoef = 0.0f;
+        float cutoffBase = 0.0f;
+        float envAmount = 0.0f;
+        float kBase = 0.0f;
+        float inputGain = 0.0f;
+        float outScale = 0.0f;
+        float sat = 0.0f;
+        float panLeft = 0.0f;       // only used while pan is modulated
+        float panRight = 0.0f;
+        float filterChar = 0.0f;    // only set while filterCharSmoothed ramps
+    };
+
+    // Poly counterpart of renderVoice() for a whole block. The mod matrix, accent
+    // and pan are shared; each voice runs its own oscillator, sub, decay and
+    // release envelopes and ladder, and the voices are summed after the ladder.
+    // The voice groups are independent jobs, so they can run on renderWorkers;
+    // they are always mixed in group order, so the result does not depend on it.
+    void renderPoly (const BlockConstants& bc, float* left, float* right, int numSamples)
+    {
+        numPolyJobs = 0;
+
+        for (int group = 0; group < numPolyGroups; ++group)
+        {
+            bool active = false;
+
+            for (int lane = 0; lane < laneWidth; ++lane)
+            {
+                const auto v = (size_t) (group * laneWidth + lane);
+                poly.releaseMul[v] = poly.gate[v] ? 1.0f : releaseCoef;
+                active = active || poly.releaseEnv[v] > 0.0f;
+            }
+
+            if (active)
+                polyJobGroups[(size_t) numPolyJobs++] = group;
+        }
+
+        const auto& tables = CoefficientTables::get();
+        const float centreGain = getPanGains (0.0f).left;
+
+        runModulation (numSamples, [&] (int i, const ModFrame& mod)
+        {
+            modEnv *= mod.modEnvCoef;
+
+            const auto ctl = bc.controlsAt (i);
+            const float accentTotal = mod.accentTotal;
+            const float resNorm = juce::jlimit (0.0f, 0.995f, ctl.res + mod.res + 0.08f * accentTotal);
+            const float driveAmt = juce::jlimit (0.0f, 1.0f, ctl.drive * (1.0f + accentTotal) + mod.drive);
+
+            auto& frame = polyFrames[(size_t) i];
+            frame.pitchRatio = mod.pitchRatio;
+            frame.envCoef = mod.envCoef;
+            frame.cutoffBase = ctl.cutoff * (1.0f + 1.2f * accentTotal) + mod.cutoff;
+            frame.envAmount = envmod * (1.0f + 0.6f * accentTotal) * 5000.0f;
+            frame.kBase = juce::jmap (tables.resCurve (resNorm), 0.0f, 1.0f, 0.0f, 4.8f);
+            frame.inputGain = (1.0f + 6.0f * driveAmt) * centreGain;
+            frame.outScale = (1.0f + 0.2f * accentTotal) * juce::jlimit (0.0f, 2.0f, ctl.gain + mod.gain);
+            frame.sat = ctl.sat;
+            frame.panLeft = mod.panLeft;
+            frame.panRight = mod.panRight;
+
+            if (! bc.filterModeStatic)
+                frame.filterChar = filterCharSmoothed.getNextValue();
+        });
+
+        polyJobConstants = &bc;
+        polyJobSamples = numSamples;
+
+        // give the workers half the block before falling back to this thread alone
+        const double deadlineMs = 500.0 * numSamples / sr;
+
+        if (renderWorkers != nullptr && numPolyJobs > 1 && renderWorkers->isAvailable())
+            renderWorkers->run (&renderPolyJob, this, numPolyJobs, deadlineMs);
+        else
+            for (int job = 0; job < numPolyJobs; ++job)
+                renderPolyGroup (job);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float y = 0.0f;
+            for (int job = 0; job < numPolyJobs; ++job)
+                y += polyGroupOutput[(size_t) (polyJobGroups[(size_t) job] * maxBlockSize + i)];
+
+            const auto& frame = polyFrames[(size_t) i];
+            y *= frame.outScale;
+
+            if (bc.panModulated)
+                writeOutput (left, right, i, { y * (frame.panLeft / centreGain), y * (frame.panRight / centreGain) });
+            else
+                writeOutput (left, right, i, { y, y });
+        }
+
+        for (size_t v = 0; v < (size_t) maxPolyVoices; ++v)
+        {
+            if (poly.releaseEnv[v] <= 0.0f)
+            {
+                poly.gate[v] = false;
+                poly.note[v] = -1;
+            }
+        }
+    }
+
+    static void renderPolyJob (void* context, int job)
+    {
+        static_cast<AcidVoice*> (context)->renderPolyGroup (job);
+    }
+
+    // Renders one group of laneWidth voices for the current block into its
+    // slot of polyGroupOutput. Only touches that group's state.
+    void renderPolyGroup (int job)
+    {
+        const auto& bc = *polyJobConstants;
+        const auto& tables = CoefficientTables::get();
+        const float invSr = 1.0f / sr;
+
+        const int group = polyJobGroups[(size_t) job];
+        const auto base = (size_t) (group * laneWidth);
+        float* output = polyGroupOutput.data() + (size_t) (group * maxBlockSize);
+        auto& filter = poly.filter[(size_t) group];
+
+        Lanes phase = loadLanes (&poly.phase[base]);
+        Lanes subPhase = loadLanes (&poly.subPhase[base]);
+        Lanes env = loadLanes (&poly.env[base]);
+        Lanes releaseEnv = loadLanes (&poly.releaseEnv[base]);
+        const Lanes baseIncrement = loadLanes (&poly.increment[base]);
+        const Lanes releaseMul = loadLanes (&poly.releaseMul[base]);
+
+        for (int i = 0; i < polyJobSamples; ++i)
+        {
+            const auto& frame = polyFrames[(size_t) i];
+
+            const auto mode = bc.filterModeStatic ? bc.mode : getMorphedFilterMode (frame.filterChar);
+            const auto kernels = bc.filterModeStatic ? bc.kernels : getFilterKernels (mode);
+
+            const Lanes increment = FastMath::clamp (baseIncrement * frame.pitchRatio, 0.0f, 0.5f);
+            phase = wrapPhase (phase + increment);
+            subPhase = wrapPhase (subPhase + increment * 0.5f);
+            env = env * frame.envCoef;
+            releaseEnv = zeroBelow (releaseEnv * releaseMul, 1.0e-4f);
+
+            Lanes osc = renderWaveLanes (phase, increment, wave);
+            if (bc.subAmt > 0.0001f)
+                osc += DspMath::sin (subPhase * juce::MathConstants<float>::twoPi) * (bc.subAmt * 0.8f);
+
+            const Lanes fc = FastMath::clamp (env * frame.envAmount + frame.cutoffBase, 20.0f, 16000.0f);
+            const Lanes g = lookupLanes (tables.onePoleG, fc * invSr);
+            const Lanes gOs = lookupLanes (tables.onePoleG, fc * (0.5f * invSr));
+
+            const Lanes y = runPolyLadder (kernels, osc * frame.inputGain, frame.kBase, g, gOs, mode, filter);
+            output[i] = sumLanes (shapeOutput (y, frame.sat) * env * releaseEnv);
+        }
+
+        storeLanes (&poly.phase[base], phase);
+        storeLanes (&poly.subPhase[base], subPhase);
+        storeLanes (&poly.env[base], env);
+        storeLanes (&poly.releaseEnv[base], releaseEnv);
+    }
+
+    void prepareBlockResources (int maximumBlockSize)
+    {
+        maxBlockSize = juce::jmax (1, maximumBlockSize);
+
+        // polyphase IIR half-band stages; integer latency so it can be reported exactly
+        for (size_t i = 0; i < oversamplers.size(); ++i)
+        {
+            oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>> (2, i + 1,
+                                                                                juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                                true, true);
+            oversamplers[i]->initProcessing ((size_t) maxBlockSize);
+        }
+
+        activeOversampler = (oversamplingLog2 == 0) ? nullptr : oversamplers[(size_t) oversamplingLog2 - 1].get();
+
+        for (auto* buffer : { &scratchLeft, &scratchRight, &scratchFc, &scratchK, &scratchChar })
+            buffer->assign ((size_t) maxBlockSize, 0.0f);
+
+        // room for the output gains still waiting out the resampler latency
+        int maxLatency = 0;
+        for (auto& os : oversamplers)
+            maxLatency = juce::jmax (maxLatency, (int) std::round (os->getLatencyInSamples()));
+
+        scratchScale.assign ((size_t) (maxBlockSize + maxLatency), 0.0f);
+
+        polyFrames.assign ((size_t) maxBlockSize, {});
+        polyGroupOutput.assign ((size_t) (numPolyGroups * maxBlockSize), 0.0f);
+    }
+
+    // Block-level guard for the ladders, whose kernels do no per-sample checks.
+    // Resets any ladder that has gone NaN/inf (returns false if one did) and
+    // flushes state values too small to matter, so a decaying ladder cannot
+    // sit in denormals when the thread runs without flush-to-zero.
+    bool sanitiseFilterStates()
+    {
+        bool allFinite = sanitise (filterMono);
+
+       #if JUCE_USE_SIMD
+        allFinite = sanitise (filterStereo) && allFinite;
+       #else
+        allFinite = sanitise (filterL) && allFinite;
+        allFinite = sanitise (filterR) && allFinite;
+       #endif
+
+        for (auto& filter : poly.filter)
+            allFinite = sanitise (filter) && allFinite;
+
+        return allFinite;
+    }
+
+    // The decay envelopes keep falling for as long as a note is held, which
+    // takes a short decay into denormals within a minute or so. They are
+    // flushed once per block like the ladder states.
+    void flushEnvelopes()
+    {
+        for (auto* value : { &env, &modEnv, &releaseEnv })
+            if (*value < denormalFloor)
+                *value = 0.0f;
+
+        for (auto& value : poly.env)
+            if (value < denormalFloor)
+                value = 0.0f;
+    }
+
+    static bool sanitise (FilterState& s)
+    {
+        // inf - inf is NaN too, so one test covers every value
+        if (std::isnan ((s.z1 - s.z1) + (s.z2 - s.z2) + (s.z3 - s.z3) + (s.z4 - s.z4) + (s.lastY - s.lastY)))
+        {
+            s = {};
+            return false;
+        }
+
+        for (auto* v : { &s.z1, &s.z2, &s.z3, &s.z4, &s.lastY })
+            if (std::abs (*v) < denormalFloor)
+                *v = 0.0f;
+
+        return true;
+    }
+
+   #if JUCE_USE_SIMD
+    static bool sanitise (FilterLanes& lanes)
+    {
+        bool allFinite = true;
+
+        for (size_t lane = 0; lane < SIMDFloat::size(); ++lane)
+        {
+            auto s = lanes.getLane (lane);
+            allFinite = sanitise (s) && allFinite;
+            lanes.setLane (lane, s);
+        }
+
+        return allFinite;
+    }
+   #endif
+
+    // far below anything audible, far above the float denormal range (1.2e-38)
+    static constexpr float denormalFloor = 1.0e-20f;
+
+    // Moves the ladder state between the single centred filter and the stereo
+    // pair when the block layout changes. While centred both channels share one
+    // state, so leaving copies it to both sides.
+    void syncFilterLayout (bool centred)
+    {
+        if (centred == monoFilterActive)
+            return;
+
+        monoFilterActive = centred;
+
+       #if JUCE_USE_SIMD
+        if (centred)
+        {
+            filterMono = filterStereo.getLane (0);
+        }
+        else
+        {
+            filterStereo.setLane (0, filterMono);
+            filterStereo.setLane (1, filterMono);
+        }
+       #else
+        if (centred)
+            filterMono = filterL;
+        else
+            filterL = filterR = filterMono;
+       #endif
+    }
+
+    // --- common voice state ---
+    float sr = 44100.0f;
+
+    float phase = 0.0f;
+    alignas (32) std::array<float, (size_t) maxUnisonVoices> unisonPhase {};
+    float phaseSub = 0.0f;
+    float lfo1Phase = 0.0f;
+    float lfo2Phase = 0.0f;
+
+    float env = 0.0f;
+    float modEnv = 0.0f;
+    float releaseEnv = 0.0f;
+    float releaseCoef = 0.0f;
+
+    float targetFreq  = 110.0f;
+    float currentFreq = 110.0f;
+
+    int activeNote = -1;
+    bool  gate = false;
+    bool glideActive = false;
+    bool releaseActive = false;
+    float vel  = 0.0f;
+    float aftertouch = 0.0f;
+    HeldNoteStack heldNotes;
+    HeldNoteStack::Priority notePriority = HeldNoteStack::Priority::last;
+    float accentKick = 0.0f;
+    float accentKickCoef = 0.0f;
+
+    // coefficients keyed on the times that drive them (recomputed only on change)
+    CachedDecayCoef glideCoefCache;
+    CachedDecayCoef envCoefCache;
+    CachedDecayCoef modEnvCoefCache;
+    CachedDecayCoef releaseCoefCache;
+    CachedPow accentShapeCache { 2.2f };
+
+    // --- control-rate modulation (see setControlRate) ---
+    int controlInterval = 1;
+    int controlCountdown = 0;
+    bool controlFrameValid = false;
+    float controlKickCoef = 0.0f;
+    ModFrame controlFrame;
+    ModFrame controlStep;
+
+    // --- params (set via setParams) ---
+    float wave    = 0.0f;     // 0..1
+    float envmod  = 0.5f;     // 0..1-ish
+    float decay   = 0.2f;     // seconds
+    float release = 0.15f;    // seconds
+    float accent  = 0.0f;     // 0..1
+    float glideMs = 0.0f;     // ms
+    float subMix  = 0.0f;     // 0..1
+    float unison  = 0.0f;     // 0..1
+    float unisonSpread = 0.0f; // 0..1
+    int targetFilterChar = 0;
+    juce::SmoothedValue<float> filterCharSmoothed;
+    juce::SmoothedValue<float> accentSmoothed;
+
+    float lfo1Rate = 0.5f;
+    float lfo2Rate = 1.25f;
+    float modEnvDecay = 0.3f;
+    std::array<ModSlot, 3> slots {};
+    juce::SmoothedValue<float> lfo1FreqSmoothed;
+    juce::SmoothedValue<float> lfo2FreqSmoothed;
+
+    // cutoff, res, drive, sat and gain (see Controls)
+    ParameterRamp cutoffRamp, resRamp, driveRamp, satRamp, gainRamp;
+    bool snapControls = true;
+
+    // --- filter state (ladder-ish) ---
+    // single ladder used while the block is centred (see syncFilterLayout)
+    FilterState filterMono;
+    bool monoFilterActive = false;
+
+   #if JUCE_USE_SIMD
+    FilterLanes filterStereo;
+   #else
+    FilterState filterL;
+    FilterState filterR;
+   #endif
+
+    // --- unison (see setUnisonVoices) ---
+    int unisonVoices = 3;
+    UnisonLayout unisonLayout;
+    UnisonPanRamp unisonPanRamp;
+    bool unisonPanModulated = false;  // pan modulated while unison plays (set per block)
+    bool unisonPanValid = false;      // unisonPanRamp holds the current gains
+
+    int panLaw = CoefficientTables::panLawMinus3dB;
+
+    // --- poly mode (see setVoiceMode) ---
+    bool polyMode = false;
+    int polyVoiceCount = 8;
+    uint32_t polyNoteCounter = 0;
+    PolyVoices poly;
+
+    // renderPoly() block state, read by the group jobs
+    RenderWorkerPool* renderWorkers = nullptr;
+    std::vector<PolyFrame> polyFrames;
+    std::vector<float> polyGroupOutput;         // numPolyGroups runs of maxBlockSize samples
+    std::array<int, (size_t) numPolyGroups> polyJobGroups {};
+    int numPolyJobs = 0;
+    const BlockConstants* polyJobConstants = nullptr;
+    int polyJobSamples = 0;
+
+    // --- oversampling (see setOversampling) ---
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, (size_t) maxOversamplingLog2> oversamplers;
+    juce::dsp::Oversampling<float>* activeOversampler = nullptr;
+    int oversamplingLog2 = 0;
+    int maxBlockSize = 512;
+
+    // base-rate per-sample values for renderOversampled(); scratchScale also
+    // holds the resampler latency's worth of delayed gains in front
+    std::vector<float> scratchLeft, scratchRight;
+    std::vector<float> scratchFc, scratchK, scratchScale, scratchChar;
 
     // kept from your original code (not used now, but harmless)
     float lp = 0.0f;
@@ -717,7 +2115,10 @@ private:
 
 
 
-class AcidSynthAudioProcessor : public juce::AudioProcessor
+class AcidSynthAudioProcessor : public juce::AudioProcessor,
+                                private juce::AudioProcessorValueTreeState::Listener,
+                                private juce::MidiKeyboardState::Listener,
+                                private juce::AsyncUpdater
 {
 public:
     AcidSynthAudioProcessor();
@@ -738,7 +2139,7 @@ public:
     bool acceptsMidi() const override { return true; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -758,19 +2159,162 @@ public:
 
     juce::AudioProcessorValueTreeState apvts;
 
-    // Used by the on-screen keyboard in the editor
+    // Used by the on-screen keyboard in the editor. Its notes reach the audio
+    // thread through uiNotes, never through the state's lock.
     juce::MidiKeyboardState keyboardState;
 
+    // Message thread: shows the host notes played since the last call on
+    // keyboardState. The editor calls it from a timer.
+    void updateKeyboardDisplay();
+
+    // FX order and per-stage CPU use; getUsage() may be read from any thread.
+    const FxChain& getFxChain() const noexcept { return fxChain; }
+
     // Your existing synth voice (must exist somewhere in your project)
     // If you already had this as a member before, keep the same type.
     AcidVoice voice;
 
 private:
-    juce::dsp::Chorus<float> chorus;
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> delayLineL { 192000 };
-    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear> delayLineR { 192000 };
-    juce::Reverb reverb;
-    float currentAftertouch = 0.0f;
+    // Every parameter's value, looked up by ID once in the constructor.
+    struct ParameterRefs
+    {
+        std::atomic<float>* wave = nullptr;
+        std::atomic<float>* cutoff = nullptr;
+        std::atomic<float>* res = nullptr;
+        std::atomic<float>* filterChar = nullptr;
+        std::atomic<float>* envmod = nullptr;
+        std::atomic<float>* decay = nullptr;
+        std::atomic<float>* release = nullptr;
+        std::atomic<float>* accent = nullptr;
+        std::atomic<float>* glide = nullptr;
+        std::atomic<float>* drive = nullptr;
+        std::atomic<float>* sat = nullptr;
+        std::atomic<float>* sub = nullptr;
+        std::atomic<float>* unison = nullptr;
+        std::atomic<float>* unisonSpread = nullptr;
+        std::atomic<float>* unisonVoices = nullptr;
+        std::atomic<float>* gain = nullptr;
+        std::atomic<float>* volume = nullptr;
+
+        std::atomic<float>* lfo1Mode = nullptr;
+        std::atomic<float>* lfo1Sync = nullptr;
+        std::atomic<float>* lfo1Rate = nullptr;
+        std::atomic<float>* lfo2Mode = nullptr;
+        std::atomic<float>* lfo2Sync = nullptr;
+        std::atomic<float>* lfo2Rate = nullptr;
+        std::atomic<float>* modEnvDecay = nullptr;
+        std::atomic<float>* modRate = nullptr;
+        std::atomic<float>* oversampling = nullptr;
+        std::atomic<float>* voiceMode = nullptr;
+        std::atomic<float>* notePriority = nullptr;
+        std::atomic<float>* panLaw = nullptr;
+        std::atomic<float>* polyVoices = nullptr;
+        std::atomic<float>* multiCore = nullptr;
+
+        std::array<std::atomic<float>*, 3> modSource {};
+        std::array<std::atomic<float>*, 3> modDest {};
+        std::array<std::atomic<float>*, 3> modAmount {};
+
+        std::atomic<float>* fxDrive = nullptr;
+        std::atomic<float>* fxChorus = nullptr;
+        std::atomic<float>* fxDelay = nullptr;
+        std::atomic<float>* fxDelayTime = nullptr;
+        std::atomic<float>* fxDelayMode = nullptr;
+        std::atomic<float>* fxDelaySync = nullptr;
+        std::atomic<float>* fxDelayPingPong = nullptr;
+        std::atomic<float>* fxReverb = nullptr;
+        std::atomic<float>* fxReverbQuality = nullptr;
+        std::atomic<float>* fxDriveQuality = nullptr;
+        std::atomic<float>* fxOrder = nullptr;
+    };
+
+    // What one block's FX stages need, gathered once in processBlock.
+    struct FxBlockInputs
+    {
+        float* left = nullptr;
+        float* right = nullptr;   // nullptr for a mono output
+        int numSamples = 0;
+        const float* driveValues = nullptr;   // the control ramps, nullptr while settled
+        const float* delayValues = nullptr;
+        float chorusMix = 0.0f;
+        float reverbMix = 0.0f;
+    };
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    void updateRenderWorkers();
+    void applyParameterChanges (double bpm);
+    void updateFxTail();
+    double getFxTailSeconds() const;
+    int getTotalLatencySamples() const;
+    void processFxStage (FxChain::Stage, FxSlot&, const FxBlockInputs&);
+    float getDelayTimeMs (double bpm) const;
+    void handleMidiEvent (const juce::MidiMessage&);
+
+    // MidiKeyboardState::Listener, called on the message thread
+    void handleNoteOn (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void pushUiNote (int midiNoteNumber, float velocity);
+    int collectUiNotes (int numSamples);
+
+    ParameterRefs params;
+
+    // smoothed FX controls; the chorus and reverb smooth their own mixes
+    ParameterRamp volumeRamp, fxDriveRamp, fxDelayRamp;
+
+    // Bumped by every parameter change (from any thread). processBlock only
+    // pushes settings into the voice (and recomputes the FX tail) when it
+    // differs from appliedGeneration, or when the host tempo or
+    // realtime/offline mode has changed.
+    std::atomic<uint32_t> parameterGeneration { 1 };
+    uint32_t appliedGeneration = 0;
+    double appliedBpm = 0.0;
+    bool appliedOffline = false;
+
+    // While the voice is idle the FX run for fxTailSamples more samples, then
+    // processBlock leaves the (cleared) buffer alone. Recomputed whenever the
+    // settings or the slot states (fxTailSlotStates) change.
+    int fxTailSamples = 0;
+    int fxTailRemaining = 0;
+    uint32_t fxTailSlotStates = 0;
+
+    // the voice's release plus the FX tail, for getTailLengthSeconds()
+    std::atomic<double> tailLengthSeconds { 0.0 };
+
+    // On-screen keyboard notes. collectUiNotes() drains the queue into
+    // blockUiNotes with sample positions: an event played t ms after the
+    // previous block started lands t ms into the current one, so UI notes
+    // keep their spacing at the cost of one block of latency.
+    struct BlockUiNote
+    {
+        int samplePosition = 0;
+        int note = 0;
+        float velocity = 0.0f;
+    };
+
+    UiNoteQueue uiNotes;
+    std::array<BlockUiNote, (size_t) UiNoteQueue::capacity> blockUiNotes {};
+    double lastBlockStartMs = 0.0;
 
+    // Host notes on their way back to keyboardState for display (audio thread
+    // to message thread); showingHostNotes keeps them out of uiNotes.
+    UiNoteQueue hostNotes;
+    bool showingHostNotes = false;
+
+    // Runs only while Multi-Core is on and the processor is prepared (block
+    // size > 0); started and stopped on the message thread.
+    RenderWorkerPool renderWorkers;
+    int renderWorkerBlockSize = 0;
+    double renderWorkerSampleRate = 44100.0;
+
+    // FX order plus the bypass slot of each stage: a slot fades its stage in
+    // and out and keeps it running until its tail is gone, instead of
+    // stopping it the moment its mix hits 0
+    FxChain fxChain;
+
+    FxDrive drive;
+    juce::dsp::Chorus<float> chorus;
+    StereoDelay delay;
+    FdnReverb reverb;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AcidSynthAudioProcessor)
 };
@@ -0,0 +1,223 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+//==============================================================================
+// A few pre-spawned realtime threads that help the audio thread through a
+// batch of independent render jobs. Jobs are claimed from a single atomic word
+// holding (batch generation, next job, job count), so handing them out never
+// locks or allocates; publishing a batch is a single store.
+//
+// Between batches the workers sleep on an event each, using no CPU. A worker
+// flags itself as parked before it waits, and run() only signals the parked
+// ones, so a worker still busy with the previous batch costs no wake-up. The
+// calling thread claims jobs as well and renders every job no worker has
+// taken yet, so a worker that is slow to wake costs nothing: the caller only
+// ever waits for jobs already running.
+//
+// A job cannot be taken back once a worker has claimed it, so the caller
+// always waits for the jobs that are running, however long that takes. When
+// the wait is longer than the deadline passed to run(), the pool reports a
+// miss and keeps itself out of use for a while, so the following batches
+// are rendered single-threaded; the late batch itself is not protected.
+//
+// start() and stop() belong to the message thread and may be called while
+// the audio thread is inside run().
+class RenderWorkerPool
+{
+public:
+    using JobFn = void (*) (void* context, int jobIndex);
+
+    static constexpr int maxWorkers = 4;
+    static constexpr int maxJobs = 0xffff;
+
+    RenderWorkerPool() = default;
+    ~RenderWorkerPool() { stop(); }
+
+    // Spawns the worker threads with the audio thread's realtime scheduling
+    // for blocks of blockSize samples at sampleRate. Call from the message
+    // thread (e.g. prepareToPlay).
+    void start (int numWorkersToUse, double sampleRate, int blockSize)
+    {
+        stop();
+
+        const auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime (juce::jmax (1, blockSize), sampleRate);
+
+        const int count = juce::jlimit (0, maxWorkers, numWorkersToUse);
+        for (int i = 0; i < count; ++i)
+        {
+            auto& worker = workers[(size_t) i];
+            worker = std::make_unique<Worker> (*this, i);
+
+            if (! worker->startRealtimeThread (options))
+                worker->startThread (juce::Thread::Priority::highest);
+        }
+
+        numWorkers.store (count);
+    }
+
+    void stop()
+    {
+        // from here on run() wakes no one and isAvailable() says no
+        const int count = numWorkers.exchange (0);
+
+        for (int i = 0; i < count; ++i)
+            workers[(size_t) i]->signalThreadShouldExit();
+
+        for (int i = 0; i < count; ++i)
+        {
+            wakeUp[(size_t) i].signal();
+            workers[(size_t) i]->stopThread (1000);
+            workers[(size_t) i].reset();
+        }
+    }
+
+    int getNumWorkers() const noexcept { return numWorkers.load (std::memory_order_relaxed); }
+
+    // False while the pool is sitting out after a missed deadline (or has no
+    // workers); the caller should then run its jobs inline.
+    bool isAvailable() noexcept
+    {
+        if (getNumWorkers() == 0)
+            return false;
+
+        if (fallbackBatches > 0)
+        {
+            --fallbackBatches;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Runs fn (context, i) for every i in [0, numJobs) across the workers and
+    // the calling thread, and returns once all of them have finished. Returns
+    // false if waiting on the workers took longer than deadlineMs; it still
+    // returned only once they had finished.
+    bool run (JobFn fn, void* context, int numJobs, double deadlineMs)
+    {
+        jassert (numJobs <= maxJobs);
+
+        if (numJobs <= 0)
+            return true;
+
+        jobFn = fn;
+        jobContext = context;
+        remaining.store (numJobs, std::memory_order_relaxed);
+
+        const uint64_t generation = (claimState.load (std::memory_order_relaxed) >> 32) + 1;
+        // sequentially consistent, as are the parked flags: see Worker::run()
+        claimState.store ((generation << 32) | (uint64_t) numJobs);
+
+        // the caller takes one job itself, so at most numJobs - 1 helpers are of use
+        const int numToWake = juce::jmin (numWorkers.load(), numJobs - 1);
+        for (int i = 0; i < numToWake; ++i)
+            if (parked[(size_t) i].exchange (false))
+                wakeUp[(size_t) i].signal();
+
+        workOnBatch();
+
+        // every job is claimed now; only the ones a worker is still running are left
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        bool metDeadline = true;
+
+        while (remaining.load (std::memory_order_acquire) > 0)
+        {
+            if (metDeadline && juce::Time::getMillisecondCounterHiRes() - start > deadlineMs)
+            {
+                metDeadline = false;
+                fallbackBatches = fallbackLength;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return metDeadline;
+    }
+
+private:
+    struct Worker : public juce::Thread
+    {
+        Worker (RenderWorkerPool& p, int workerIndex)
+            : juce::Thread ("Acid render worker"), pool (p), index ((size_t) workerIndex) {}
+
+        void run() override
+        {
+            // the jobs run the same DSP as the audio thread, so they get the same FTZ/DAZ mode
+            juce::ScopedNoDenormals noDenormals;
+
+            uint64_t seenGeneration = pool.claimState.load() >> 32;
+
+            while (! threadShouldExit())
+            {
+                const uint64_t generation = pool.claimState.load() >> 32;
+
+                if (generation != seenGeneration)
+                {
+                    seenGeneration = generation;
+                    pool.workOnBatch();
+                    continue;
+                }
+
+                // Flag first, then look once more: run() publishes the batch
+                // before it reads the flag, so either the batch is seen here
+                // or run() signals. A leftover signal only costs a spare loop.
+                pool.parked[index].store (true);
+
+                if ((pool.claimState.load() >> 32) == seenGeneration && ! threadShouldExit())
+                    pool.wakeUp[index].wait (-1);
+
+                pool.parked[index].store (false);
+            }
+        }
+
+        RenderWorkerPool& pool;
+        const size_t index;
+    };
+
+    // Claims and runs jobs of the current batch until none are left.
+    void workOnBatch()
+    {
+        for (;;)
+        {
+            uint64_t state = claimState.load (std::memory_order_acquire);
+            const auto next = (int) ((state >> 16) & 0xffff);
+            const auto count = (int) (state & 0xffff);
+
+            if (next >= count)
+                return;
+
+            // the generation lives in the same word, so a claim can never land in a later batch
+            if (! claimState.compare_exchange_weak (state, state + (1u << 16),
+                                                    std::memory_order_acq_rel, std::memory_order_acquire))
+                continue;
+
+            jobFn (jobContext, next);
+            remaining.fetch_sub (1, std::memory_order_release);
+        }
+    }
+
+    // batches to render single-threaded after a miss (about a second of 256-sample blocks)
+    static constexpr int fallbackLength = 200;
+
+    std::array<std::unique_ptr<Worker>, maxWorkers> workers;
+    std::atomic<int> numWorkers { 0 };
+    int fallbackBatches = 0;
+
+    // owned by the pool rather than the workers, so a run() racing stop()
+    // never signals a destroyed thread
+    std::array<juce::WaitableEvent, maxWorkers> wakeUp;
+    std::array<std::atomic<bool>, maxWorkers> parked {};
+
+    // generation (bits 32-63), next job (16-31), job count (0-15)
+    std::atomic<uint64_t> claimState { 0 };
+    std::atomic<int> remaining { 0 };
+    JobFn jobFn = nullptr;
+    void* jobContext = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (RenderWorkerPool)
+};
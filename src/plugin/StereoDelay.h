@@ -0,0 +1,264 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterRamp.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+// The FX delay: two feedback delay lines, processed a block at a time.
+//
+// Each line is a power-of-two ring sized in prepare() from the sample rate and
+// the longest delay time, plus one guard sample mirroring the first, so a
+// linearly interpolated read of a whole span is two contiguous vector ops.
+// A block is worked through in chunks no longer than the delay, so every read
+// in a chunk comes from samples written before it and the chunk's writes are
+// one contiguous copy (two at the wrap).
+//
+// reset() leaves the rings as they are, so it is cheap on the audio thread:
+// it only restarts a count of the samples written since, and any tap older
+// than that count reads as silence.
+//
+// The mix control is a send: it scales what goes into the lines (and sets the
+// feedback), while the repeats come back at full level. Turning it down
+// therefore lets the echoes already in the lines ring out. Delay time
+// changes are ramped; while a ramp runs the reads move per sample. In
+// ping-pong mode the input goes into the left line only and the two lines
+// feed each other, so the repeats alternate sides.
+class StereoDelay
+{
+public:
+    // The mix control also sets the feedback: more delay means longer repeats.
+    static float getFeedback (float mix) noexcept { return 0.35f + 0.25f * mix; }
+
+    void prepare (double sampleRate, double maxDelaySeconds, int maximumBlockSize)
+    {
+        sr = sampleRate;
+        maxDelaySamples = (float) (sampleRate * maxDelaySeconds);
+
+        const int size = juce::nextPowerOfTwo ((int) std::ceil (maxDelaySamples) + 2);
+        mask = size - 1;
+        lineL.assign ((size_t) size + 1, 0.0f);
+        lineR.assign ((size_t) size + 1, 0.0f);
+        writePos = 0;
+        samplesWritten = 0;
+
+        const auto blockSize = (size_t) juce::jmax (1, maximumBlockSize);
+        delayedL.assign (blockSize, 0.0f);
+        delayedR.assign (blockSize, 0.0f);
+        feedL.assign (blockSize, 0.0f);
+        feedR.assign (blockSize, 0.0f);
+        feedback.assign (blockSize, 0.0f);
+
+        delayRamp.prepare (sampleRate, 0.25, maximumBlockSize);
+    }
+
+    // Silences the repeats (see the class comment).
+    void reset()
+    {
+        samplesWritten = 0;
+        delayRamp.setCurrentAndTargetValue (delayRamp.getTargetValue());
+    }
+
+    // Glides to the new time over 250 ms (tape style) unless smoothed is false.
+    void setDelayTimeMs (float ms, bool smoothed = true) noexcept
+    {
+        const float samples = clampDelay (ms * 0.001f * (float) sr);
+
+        if (smoothed)
+            delayRamp.setTargetValue (samples);
+        else
+            delayRamp.setCurrentAndTargetValue (samples);
+    }
+
+    void setPingPong (bool shouldPingPong) noexcept { pingPong = shouldPingPong; }
+
+    // Sends left and right (which may be nullptr for a mono output) into the
+    // lines at the given mix and adds the repeats to them. mixValues holds a
+    // per-sample mix while it ramps, or is nullptr to use mix for the whole block.
+    void process (float* left, float* right, int numSamples, const float* mixValues, float mix)
+    {
+        if (numSamples > (int) feedback.size())
+        {
+            jassertfalse;  // longer than the block size given to prepare()
+            numSamples = (int) feedback.size();
+        }
+
+        const float* delayValues = delayRamp.process (numSamples);
+        const float delay = delayRamp.getTargetValue();
+
+        // a ramp is monotonic, so its shortest delay is at one of the ends
+        const float shortest = (delayValues != nullptr) ? juce::jmin (delayValues[0], delayValues[numSamples - 1]) : delay;
+        const int maxChunk = juce::jmax (1, (int) shortest - 1);
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int n = juce::jmin (maxChunk, numSamples - start);
+            const float* mixChunk = (mixValues != nullptr) ? mixValues + start : nullptr;
+
+            if (delayValues != nullptr)
+            {
+                readModulated (lineL, delayedL.data(), delayValues + start, n);
+                if (right != nullptr)
+                    readModulated (lineR, delayedR.data(), delayValues + start, n);
+            }
+            else
+            {
+                read (lineL, delayedL.data(), delay, n);
+                if (right != nullptr)
+                    read (lineR, delayedR.data(), delay, n);
+            }
+
+            processChunk (left + start, (right != nullptr) ? right + start : nullptr, n, mixChunk, mix);
+            writePos = (writePos + n) & mask;
+            samplesWritten = juce::jmin (samplesWritten + n, mask + 1);
+            start += n;
+        }
+    }
+
+private:
+    float clampDelay (float samples) const noexcept
+    {
+        return juce::jlimit (2.0f, juce::jmax (2.0f, maxDelaySamples), samples);
+    }
+
+    void processChunk (float* left, float* right, int n, const float* mixValues, float mix)
+    {
+        using FVO = juce::FloatVectorOperations;
+        const float* dl = delayedL.data();
+        const float* dr = delayedR.data();
+
+        if (mixValues != nullptr)
+        {
+            FVO::copyWithMultiply (feedback.data(), mixValues, 0.25f, n);
+            FVO::add (feedback.data(), getFeedback (0.0f), n);
+        }
+
+        auto addFeedback = [&] (float* dest, const float* delayed)
+        {
+            if (mixValues != nullptr)
+                FVO::addWithMultiply (dest, delayed, feedback.data(), n);
+            else
+                FVO::addWithMultiply (dest, delayed, getFeedback (mix), n);
+        };
+
+        // dest = input * mix (the send), before the feedback is added
+        auto sendInput = [&] (float* dest, const float* input, float scale)
+        {
+            if (mixValues != nullptr)
+            {
+                FVO::multiply (dest, input, mixValues, n);
+                if (scale != 1.0f)
+                    FVO::multiply (dest, scale, n);
+            }
+            else
+            {
+                FVO::copyWithMultiply (dest, input, mix * scale, n);
+            }
+        };
+
+        if (right == nullptr)
+        {
+            sendInput (feedL.data(), left, 1.0f);
+            addFeedback (feedL.data(), dl);
+            write (lineL, feedL.data(), n);
+            FVO::add (left, dl, n);
+            return;
+        }
+
+        if (pingPong)
+        {
+            FVO::add (feedR.data(), left, right, n);
+            sendInput (feedL.data(), feedR.data(), 0.5f);
+            addFeedback (feedL.data(), dr);
+            FVO::clear (feedR.data(), n);
+            addFeedback (feedR.data(), dl);
+        }
+        else
+        {
+            sendInput (feedL.data(), left, 1.0f);
+            sendInput (feedR.data(), right, 1.0f);
+            addFeedback (feedL.data(), dl);
+            addFeedback (feedR.data(), dr);
+        }
+
+        write (lineL, feedL.data(), n);
+        write (lineR, feedR.data(), n);
+        FVO::add (left, dl, n);
+        FVO::add (right, dr, n);
+    }
+
+    // n samples at a fixed delay: the fraction is the same for every sample,
+    // so each contiguous span is a two-tap crossfade.
+    void read (const std::vector<float>& line, float* dest, float delay, int n) const
+    {
+        using FVO = juce::FloatVectorOperations;
+
+        const float whole = std::floor (delay);
+        const float frac = delay - whole;
+        int pos = (writePos - (int) whole - 1) & mask;   // the older of the two taps
+
+        for (int done = 0; done < n;)
+        {
+            const int span = juce::jmin (n - done, mask + 1 - pos);
+            const float* older = line.data() + pos;
+
+            // delay - whole = frac, so the newer tap gets 1 - frac
+            FVO::copyWithMultiply (dest + done, older + 1, 1.0f - frac, span);
+            FVO::addWithMultiply (dest + done, older, frac, span);
+
+            done += span;
+            pos = 0;
+        }
+
+        // sample i reads the taps written whole - i and whole + 1 - i samples
+        // ago; the ones from before the last reset count as silence
+        const int stale = (int) whole - samplesWritten;
+        if (stale >= 0)
+        {
+            FVO::clear (dest, juce::jmin (stale, n));
+            if (stale < n)
+                dest[stale] = (1.0f - frac) * line[(size_t) ((writePos - samplesWritten) & mask)];
+        }
+    }
+
+    // n samples whose delay moves per sample.
+    void readModulated (const std::vector<float>& line, float* dest, const float* delays, int n) const
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            const float readPos = (float) (writePos + i) - delays[i];
+            const float whole = std::floor (readPos);
+            const float frac = readPos - whole;
+            const int pos = (int) whole & mask;
+
+            // taps from before the last reset count as silence
+            const int olderAge = writePos - (int) whole;
+            const float older = (olderAge <= samplesWritten) ? line[(size_t) pos] : 0.0f;
+            const float newer = (olderAge - 1 <= samplesWritten) ? line[(size_t) pos + 1] : 0.0f;
+
+            dest[i] = older + frac * (newer - older);
+        }
+    }
+
+    void write (std::vector<float>& line, const float* src, int n)
+    {
+        const int first = juce::jmin (n, mask + 1 - writePos);
+        juce::FloatVectorOperations::copy (line.data() + writePos, src, first);
+        juce::FloatVectorOperations::copy (line.data(), src + first, n - first);
+
+        if (writePos == 0 || first < n)
+            line[(size_t) mask + 1] = line[0];   // keep the guard sample in step
+    }
+
+    double sr = 44100.0;
+    float maxDelaySamples = 0.0f;
+    int mask = 0;
+    int writePos = 0;
+    int samplesWritten = 0;   // since the last reset, up to mask + 1
+    bool pingPong = false;
+
+    std::vector<float> lineL, lineR;
+    std::vector<float> delayedL, delayedR, feedL, feedR, feedback;
+    ParameterRamp delayRamp;
+};
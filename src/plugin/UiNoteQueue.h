@@ -0,0 +1,91 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//==============================================================================
+// Note events on their way from one thread to another: on-screen keyboard
+// notes to the audio thread, and host notes back to the keyboard display.
+// One thread pushes and one thread pops; each side owns one index of a fixed
+// ring and only publishes it with a release store, so neither side ever waits
+// on the other or allocates.
+//
+// Note-offs are never dropped. A note-on is only queued while more than
+// numKeys slots are free, and a note-off only for a key whose note-on was
+// queued (any other has nothing to stop), so the ring always has a slot for
+// every note-off it still owes. When the consumer falls behind, only new
+// notes are lost, and no note is left hanging.
+class UiNoteQueue
+{
+public:
+    struct Event
+    {
+        double timeMs = 0.0;    // juce::Time::getMillisecondCounterHiRes() when it was played
+        int8_t note = 0;
+        float velocity = 0.0f;  // 0 for a note-off
+    };
+
+    static constexpr int capacity = 256;
+    static constexpr int numKeys = 128;
+
+    // Producer side. Returns false (and drops the event) if it is a note-on
+    // and the consumer has fallen too far behind, e.g. while the host isn't
+    // processing.
+    bool push (const Event& event) noexcept
+    {
+        auto& owed = noteOffOwed[(size_t) (event.note & 0x7f)];
+        const bool isNoteOff = event.velocity <= 0.0f;
+
+        if (isNoteOff && ! owed)
+            return true;
+
+        const uint32_t write = writeIndex.load (std::memory_order_relaxed);
+        const uint32_t limit = (uint32_t) (isNoteOff ? capacity : capacity - numKeys);
+
+        if (write - readIndex.load (std::memory_order_acquire) >= limit)
+        {
+            jassert (! isNoteOff);  // the reserve guarantees this never happens
+            return false;
+        }
+
+        events[write & mask] = event;
+        writeIndex.store (write + 1, std::memory_order_release);
+        owed = ! isNoteOff;
+        return true;
+    }
+
+    // Producer side. Queues a note-off for every key still sounding.
+    void pushAllNotesOff (double timeMs) noexcept
+    {
+        for (int note = 0; note < numKeys; ++note)
+            push ({ timeMs, (int8_t) note, 0.0f });
+    }
+
+    // Consumer side. Calls fn (const Event&) for every queued event, oldest first.
+    template <typename Fn>
+    void popAll (Fn&& fn) noexcept
+    {
+        const uint32_t write = writeIndex.load (std::memory_order_acquire);
+        uint32_t read = readIndex.load (std::memory_order_relaxed);
+
+        for (; read != write; ++read)
+            fn (events[read & mask]);
+
+        readIndex.store (read, std::memory_order_release);
+    }
+
+private:
+    static_assert ((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert (capacity > numKeys, "the ring must hold a note-off for every key");
+    static constexpr uint32_t mask = (uint32_t) capacity - 1;
+
+    std::array<Event, (size_t) capacity> events {};
+
+    // producer only: keys whose note-on went into the ring without a note-off after it
+    std::array<bool, (size_t) numKeys> noteOffOwed {};
+
+    // free-running counters; only their difference and low bits matter
+    alignas (64) std::atomic<uint32_t> writeIndex { 0 };
+    alignas (64) std::atomic<uint32_t> readIndex { 0 };
+};
@@ -0,0 +1,82 @@
+#include <JuceHeader.h>
+#include "plugin/CoefficientCache.h"
+#include <cmath>
+#include <functional>
+
+//==============================================================================
+// Checks the cached coefficients against the exact expressions they replace:
+// the lookup tables over each table's domain, to the tolerances documented in
+// CoefficientCache.h, and the keyed caches for exact agreement.
+class CoefficientCacheTests : public juce::UnitTest
+{
+public:
+    CoefficientCacheTests() : juce::UnitTest ("CoefficientCache", "AcidLadder") {}
+
+    void runTest() override
+    {
+        const auto& tables = CoefficientTables::get();
+        constexpr double pi = juce::MathConstants<double>::pi;
+
+        beginTest ("onePoleG");
+        checkTable ("onePoleG", tables.onePoleG, 0.0f, 1.0f, 2.0e-6,
+                    [=] (double w) { return 1.0 - std::exp (-2.0 * pi * w); });
+
+        beginTest ("pitchRatio");
+        checkTable ("pitchRatio", tables.pitchRatio, -36.0f, 36.0f, 5.0e-6,
+                    [] (double semis) { return std::pow (2.0, semis / 12.0); });
+        expectEquals (tables.pitchRatio (0.0f), 1.0f, "an unmodulated pitch must stay exactly 1");
+
+        beginTest ("resCurve");
+        checkTable ("resCurve", tables.resCurve, 0.0f, 1.0f, 2.0e-5,
+                    [] (double r) { return std::pow (r, 1.35); });
+
+        beginTest ("pan laws");
+        auto equalPower = [=] (double pan) { return std::cos ((pan + 1.0) * 0.25 * pi); };
+        auto linear = [] (double pan) { return 0.5 * (1.0 - pan); };
+
+        checkTable ("pan -3 dB", tables.panLeft[CoefficientTables::panLawMinus3dB], -1.0f, 1.0f, 1.0e-6, equalPower);
+        checkTable ("pan -4.5 dB", tables.panLeft[CoefficientTables::panLawMinus4_5dB], -1.0f, 1.0f, 1.0e-6,
+                    [=] (double pan) { return std::sqrt (juce::jmax (0.0, equalPower (pan)) * linear (pan)); });
+        checkTable ("pan -6 dB", tables.panLeft[CoefficientTables::panLawMinus6dB], -1.0f, 1.0f, 1.0e-6, linear);
+
+        // the centre sits on a grid point, so each law's centre level is exact
+        const float centreLevels[] = { (float) std::sqrt (0.5), (float) std::sqrt (0.5 * std::sqrt (0.5)), 0.5f };
+        for (int law = 0; law < CoefficientTables::numPanLaws; ++law)
+            expectWithinAbsoluteError (tables.panLeft[(size_t) law] (0.0f), centreLevels[law], 1.0e-7f,
+                                       "pan law " + juce::String (law) + " centre level");
+
+        beginTest ("CachedDecayCoef");
+        CachedDecayCoef decay;
+        for (float seconds : { 0.001f, 0.25f, 0.25f, 3.0f, 0.0f, 0.5f })
+        {
+            const float expected = (seconds <= 0.0f) ? 0.0f : std::exp (-1.0f / (48000.0f * seconds));
+            expectEquals (decay.get (seconds, 48000.0f), expected, "decay coefficient for " + juce::String (seconds) + " s");
+        }
+
+        beginTest ("CachedPow");
+        CachedPow power (1.35f);
+        for (float x : { 0.0f, 0.3f, 0.3f, 0.9f, 1.0f, 0.3f })
+            expectEquals (power.get (x), std::pow (x, 1.35f), "pow for " + juce::String (x));
+    }
+
+private:
+    // Worst absolute error of a table against exact over its whole domain,
+    // sampled well between the grid points.
+    void checkTable (const juce::String& name, const juce::dsp::LookupTableTransform<float>& table,
+                     float lo, float hi, double bound, const std::function<double (double)>& exact)
+    {
+        constexpr int numSteps = 1 << 18;
+        double worst = 0.0;
+
+        for (int i = 0; i <= numSteps; ++i)
+        {
+            const auto x = (float) (lo + ((double) hi - (double) lo) * i / numSteps);
+            worst = juce::jmax (worst, std::abs ((double) table (x) - exact ((double) x)));
+        }
+
+        logMessage (name + ": worst error " + juce::String (worst, 3, true) + ", bound " + juce::String (bound, 3, true));
+        expectLessOrEqual (worst, bound, name + " exceeds its documented tolerance");
+    }
+};
+
+static CoefficientCacheTests coefficientCacheTests;
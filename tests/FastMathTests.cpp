@@ -0,0 +1,150 @@
+#include <JuceHeader.h>
+#include "plugin/FastMath.h"
+#include <array>
+#include <cmath>
+
+//==============================================================================
+// Sweeps every FastMath approximation over the domain stated in FastMath.h
+// and checks the worst error against the bound written there, for the scalar
+// and (when available) the SIMD overloads.
+class FastMathTests : public juce::UnitTest
+{
+public:
+    FastMathTests() : juce::UnitTest ("FastMath", "AcidLadder") {}
+
+    void runTest() override
+    {
+        beginTest ("exp2");
+        checkRelative ("exp2", -126.0f, 126.0f, 3.0e-7,
+                       [] (auto x) { return FastMath::exp2 (x); },
+                       [] (double x) { return std::exp2 (x); });
+
+        beginTest ("exp");
+        checkRelative ("exp", -87.0f, 87.0f, 5.0e-6,
+                       [] (auto x) { return FastMath::exp (x); },
+                       [] (double x) { return std::exp (x); });
+        checkRelative ("exp near 0", -1.0f, 1.0f, 3.0e-7,
+                       [] (auto x) { return FastMath::exp (x); },
+                       [] (double x) { return std::exp (x); });
+
+        beginTest ("sin");
+        checkAbsolute ("sin", -1000.0f, 1000.0f, 3.0e-7,
+                       [] (auto x) { return FastMath::sin (x); },
+                       [] (double x) { return std::sin (x); });
+
+        beginTest ("cos");
+        checkAbsolute ("cos", -1000.0f, 1000.0f, 3.0e-7,
+                       [] (auto x) { return FastMath::cos (x); },
+                       [] (double x) { return std::cos (x); });
+
+        beginTest ("tanh");
+        // "all x": the Pade range, its saturated surroundings and the far tails
+        checkAbsolute ("tanh", -10.0f, 10.0f, 1.0e-4,
+                       [] (auto x) { return FastMath::tanh (x); },
+                       [] (double x) { return std::tanh (x); });
+        checkAbsolute ("tanh tails", -1.0e6f, 1.0e6f, 1.0e-4,
+                       [] (auto x) { return FastMath::tanh (x); },
+                       [] (double x) { return std::tanh (x); });
+
+        beginTest ("lane helpers");
+        checkExact ("abs", -100.0f, 100.0f,
+                    [] (auto x) { return FastMath::abs (x); },
+                    [] (float x) { return std::abs (x); });
+        checkExact ("clamp", -3.0f, 3.0f,
+                    [] (auto x) { return FastMath::clamp (x, -1.5f, 2.0f); },
+                    [] (float x) { return juce::jlimit (-1.5f, 2.0f, x); });
+        checkExact ("divide", -50.0f, 50.0f,
+                    [] (auto x) { return FastMath::divide (x, x * x + 0.75f); },
+                    [] (float x) { return x / (x * x + 0.75f); });
+    }
+
+private:
+    static constexpr int numSteps = 1 << 20;
+
+    // Calls fn (x) for numSteps + 1 evenly spaced x in [lo, hi], plus lo and hi themselves.
+    template <typename Fn>
+    static void sweep (float lo, float hi, Fn&& fn)
+    {
+        const double step = ((double) hi - (double) lo) / numSteps;
+        for (int i = 0; i <= numSteps; ++i)
+            fn ((float) ((double) lo + step * i));
+
+        fn (lo);
+        fn (hi);
+    }
+
+   #if JUCE_USE_SIMD
+    using SIMDFloat = FastMath::SIMDFloat;
+
+    // The SIMD overload's result for a register loaded from xs.
+    template <typename Approx>
+    static std::array<float, SIMDFloat::SIMDNumElements> evaluateLanes (Approx&& approx, const float* xs)
+    {
+        alignas (32) std::array<float, SIMDFloat::SIMDNumElements> in {}, out {};
+        std::copy (xs, xs + in.size(), in.begin());
+        approx (SIMDFloat::fromRawArray (in.data())).copyToRawArray (out.data());
+        return out;
+    }
+   #endif
+
+    // Worst error of the scalar and SIMD versions; error (approx, x) gives one sample's error.
+    template <typename Approx, typename Error>
+    void check (const juce::String& name, float lo, float hi, double bound, Approx&& approx, Error&& error)
+    {
+        double worstScalar = 0.0, worstSimd = 0.0;
+
+        sweep (lo, hi, [&] (float x)
+        {
+            worstScalar = juce::jmax (worstScalar, error ((double) approx (x), x));
+        });
+
+       #if JUCE_USE_SIMD
+        constexpr auto width = SIMDFloat::SIMDNumElements;
+        std::array<float, width> xs {};
+        size_t filled = 0;
+
+        sweep (lo, hi, [&] (float x)
+        {
+            xs[filled++] = x;
+            if (filled < width)
+                return;
+
+            const auto ys = evaluateLanes (approx, xs.data());
+            for (size_t i = 0; i < width; ++i)
+                worstSimd = juce::jmax (worstSimd, error ((double) ys[i], xs[i]));
+
+            filled = 0;
+        });
+       #endif
+
+        logMessage (name + ": worst scalar error " + juce::String (worstScalar, 3, true)
+                    + ", SIMD " + juce::String (worstSimd, 3, true) + ", bound " + juce::String (bound, 3, true));
+        expectLessOrEqual (worstScalar, bound, name + " (scalar) exceeds its documented bound");
+        expectLessOrEqual (worstSimd, bound, name + " (SIMD) exceeds its documented bound");
+    }
+
+    template <typename Approx, typename Reference>
+    void checkAbsolute (const juce::String& name, float lo, float hi, double bound, Approx&& approx, Reference&& reference)
+    {
+        check (name, lo, hi, bound, approx, [&] (double y, float x) { return std::abs (y - reference ((double) x)); });
+    }
+
+    template <typename Approx, typename Reference>
+    void checkRelative (const juce::String& name, float lo, float hi, double bound, Approx&& approx, Reference&& reference)
+    {
+        check (name, lo, hi, bound, approx, [&] (double y, float x)
+        {
+            const double exact = reference ((double) x);
+            return std::abs (y - exact) / exact;
+        });
+    }
+
+    // The lane helpers are not approximations: they must agree bit for bit.
+    template <typename Approx, typename Reference>
+    void checkExact (const juce::String& name, float lo, float hi, Approx&& approx, Reference&& reference)
+    {
+        check (name, lo, hi, 0.0, approx, [&] (double y, float x) { return std::abs (y - (double) reference (x)); });
+    }
+};
+
+static FastMathTests fastMathTests;
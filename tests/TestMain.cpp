@@ -0,0 +1,16 @@
+#include <JuceHeader.h>
+
+// Runs every juce::UnitTest in the "AcidLadder" category; the exit code is the
+// number of failed tests, so CTest sees any failure.
+int main()
+{
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTestsInCategory ("AcidLadder");
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult (i)->failures;
+
+    return failures;
+}